@@ -0,0 +1,74 @@
+/**
+ * @file binarychannel.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Benchmark of the BinaryChannel against the FileChannel (time per call and bytes written).
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <filesystem>
+
+#include "../headers/log/log.hpp"
+#include "../headers/log/log_filechannel.hpp"
+#include "../headers/log/log_binarychannel.hpp"
+
+/**
+ * @brief Gets the size of every file under a path.
+ * 
+ * @param path The path.
+ * @return size_t The size in bytes.
+ */
+size_t pathSize(const std::filesystem::path& path)
+{
+  // A single file
+  if(std::filesystem::is_regular_file(path)) return std::filesystem::file_size(path);
+  // A directory
+  size_t size = 0;
+  for(const auto& entry : std::filesystem::recursive_directory_iterator(path))
+  {
+    if(entry.is_regular_file()) size += entry.file_size();
+  }
+  return size;
+}
+
+int main()
+{
+  // Number of the iterations
+  const size_t iterations = 1000000;
+  // A clean place for the files
+  std::filesystem::path root = std::filesystem::temp_directory_path() / "drlog_binary_bench";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+
+  // FileChannel through the Log ----
+  {
+    drlog.addChannel(0, std::make_shared<drLog::FileChannel>((root / "text").string(), drLog::LogLevel::LOG_LEVEL_NORMAL, "%Y-%m-%d %H:%M:%S.%f"));
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i) drlog.info("worker") << "Request " << i << " served in " << 0.5 * i << " us";
+    drlog.flush();
+    auto end = std::chrono::steady_clock::now();
+    drlog.removeChannel(0);
+    std::cout << "FileChannel:   " << std::chrono::duration<double, std::nano>(end - start).count() / iterations << " ns/call, " << pathSize(root / "text") << " bytes\n";
+  }
+
+  // BinaryChannel directly ----
+  {
+    auto channel = std::make_shared<drLog::BinaryChannel>((root / "binary.bin").string(), drLog::LogLevel::LOG_LEVEL_NORMAL, "%Y-%m-%d %H:%M:%S.%f");
+    static const uint32_t sender = channel->registerSender("worker");
+    static const uint32_t format = channel->registerFormat("Request {} served in {} us");
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i) channel->post(sender, format, drLog::MsgLevel::MSG_L_MEDIUM, drLog::MsgType::LOG_INFO, i, 0.5 * i);
+    channel->flush();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "BinaryChannel: " << std::chrono::duration<double, std::nano>(end - start).count() / iterations << " ns/call, " << pathSize(root / "binary.bin") << " bytes\n";
+  }
+
+  // Clean up
+  std::filesystem::remove_all(root);
+  return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file jsonchannel.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Benchmark of the streaming JsonChannel (per record and batched) against the nlohmann::json serialization (and a check that they give the same bytes).
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "../headers/log/log.hpp"
+#include "../headers/log/log_jsonchannel.hpp"
+#include "../headers/vendor/nlohmann/json.hpp"
+
+/**
+ * @brief Serializes a record the old way (through a nlohmann::json object).
+ * 
+ * @param formatter The timestamp formatter.
+ * @param record The record.
+ * @return std::string The json line.
+ */
+std::string nlohmannLine(Utils::DateTime::TimeStampFormatter& formatter, const drLog::LogRecord& record)
+{
+  nlohmann::json entry;
+  entry["timestamp"] = formatter.format(record.dateTime);
+  entry["type"] = drLog::getMsgTypeStr(record.type);
+  entry["sender"] = record.className;
+  entry["message"] = record.message;
+  return entry.dump();
+}
+
+int main()
+{
+  // Number of the iterations
+  const size_t iterations = 1000000;
+  // The messages (a clean one, a long one, and ones with escapes)
+  std::vector<std::string> messages = {
+    "Request 42 served in 0.5 us",
+    std::string(512, 'a') + " long message " + std::string(512, 'b'),
+    "Quote \" backslash \\ newline \n tab \t and more \r \b \f",
+    std::string("Control \x01\x1f\x7f characters, UTF-8: \xc3\xa1rv\xc3\xadzt\xc5\xb1r\xc5\x91 t\xc3\xbck\xc3\xb6rf\xc3\xbar\xc3\xb3g\xc3\xa9p"),
+  };
+  // The last line of the channel
+  std::string line;
+  drLog::JsonChannel channel([&line](const std::string json){ line = json; }, drLog::LogLevel::LOG_LEVEL_DEBUG, "%Y-%m-%d %H:%M:%S.%L");
+  Utils::DateTime::TimeStampFormatter formatter("%Y-%m-%d %H:%M:%S.%L");
+
+  // Byte compatibility ----
+  for(const std::string& message : messages)
+  {
+    drLog::LogRecord record = { .className = "wor\"ker", .message = message, .level = drLog::MsgLevel::MSG_L_MEDIUM, .type = drLog::MsgType::LOG_WARNING,
+                                  .dateTime = std::chrono::system_clock::now(), .fields = {}, .senderId = 0, .location = std::source_location() };
+    channel.write(record);
+    if(line != nlohmannLine(formatter, record))
+    {
+      std::cerr << "!!!--> Different output:\n" << line << "\n" << nlohmannLine(formatter, record) << "\n<--!!!\n";
+      return 1;
+    }
+  }
+  std::cout << "Output is the same as nlohmann::json::dump()\n";
+
+  // Speed ----
+  for(const std::string& message : messages)
+  {
+    drLog::LogRecord record = { .className = "worker", .message = message, .level = drLog::MsgLevel::MSG_L_MEDIUM, .type = drLog::MsgType::LOG_INFO,
+                                  .dateTime = std::chrono::system_clock::now(), .fields = {}, .senderId = 0, .location = std::source_location() };
+    // nlohmann::json
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i) bytes += nlohmannLine(formatter, record).size();
+    auto end = std::chrono::steady_clock::now();
+    double nlohmannTime = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    // JsonChannel
+    start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i) channel.write(record);
+    end = std::chrono::steady_clock::now();
+    double channelTime = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    // JsonChannel in batching mode
+    size_t batches = 0;
+    size_t batchBytes = 0;
+    {
+      drLog::JsonChannel batchChannel([&batches, &batchBytes](std::string_view batch){ ++batches; batchBytes += batch.size(); }, drLog::JsonBatchPolicy(), drLog::LogLevel::LOG_LEVEL_DEBUG, "%Y-%m-%d %H:%M:%S.%L");
+      start = std::chrono::steady_clock::now();
+      for(size_t i = 0; i < iterations; ++i) batchChannel.write(record);
+      batchChannel.flush();
+      end = std::chrono::steady_clock::now();
+    }
+    double batchTime = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    std::cout << message.size() << " byte message: nlohmann " << nlohmannTime << " ns/record, JsonChannel " << channelTime << " ns/record, batched " << batchTime << " ns/record in " << batches << " batches of " << batchBytes / std::max<size_t>(batches, 1) << " bytes (" << bytes / iterations << " bytes)\n";
+  }
+  return 0;
+}
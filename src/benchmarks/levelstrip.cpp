@@ -0,0 +1,100 @@
+/**
+ * @file levelstrip.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Benchmark of the posts stripped at compile time (DRLOG_MIN_LEVEL) against the posts filtered at runtime.
+ * @details This file is compiled with DRLOG_MIN_LEVEL = 1, so the debug posts are stripped.
+ * The strippedPosts() function has only stripped posts, so its generated code must be an empty function:
+ *   objdump -d --no-show-raw-insn levelstrip | awk '/<_Z13strippedPostsm>:/,/^$/'
+ * shows only a 'ret' (and no call to the formatting functions). The DRLOG_* macros leave no code even at -O0.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#define DRLOG_MIN_LEVEL 1
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <type_traits>
+
+#include "../headers/log/log.hpp"
+
+// The stripped posts have no state and no code ----
+  static_assert(std::is_same_v<decltype(drlog.debug("main")), drLog::Log::NullPost>, "The debug posts must be stripped");
+  static_assert(std::is_same_v<decltype(drlog.info("main")), drLog::Log::LogPost>, "The info posts must stay");
+  static_assert(std::is_empty_v<drLog::Log::NullPost>, "A stripped post must not have a state");
+
+// Number of the evaluated arguments
+static size_t evaluations = 0;
+
+/**
+ * @brief A costly argument with a side effect (so it can't be removed if it is evaluated).
+ * 
+ * @param i The iteration.
+ * @return std::string The argument.
+ */
+[[gnu::noinline]] std::string expensive(size_t i)
+{
+  ++evaluations;
+  return std::to_string(i) + " items";
+}
+
+/**
+ * @brief Posts that are all stripped (the generated code should be empty).
+ * 
+ * @param i The iteration.
+ */
+[[gnu::noinline]] void strippedPosts(size_t i)
+{
+  drlog.debug("main") << "Request " << i << " served in " << 0.25 * double(i) << " ms";
+  drlog.msg<drLog::MsgLevel::MSG_L_DEBUG>("main").field("request", i) << "Request " << i;
+  DRLOG_DEBUG("main") << "Request " << i << " with " << expensive(i);
+}
+
+/**
+ * @brief Runs a benchmark and prints its results.
+ * 
+ * @tparam Fn Type of the benchmarked function.
+ * @param name Name of the benchmark.
+ * @param iterations Number of the iterations.
+ * @param fn The benchmarked function.
+ */
+template<typename Fn>
+void run(const std::string& name, size_t iterations, Fn&& fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < iterations; ++i) fn(i);
+  auto end = std::chrono::steady_clock::now();
+  std::cout << name << ": " << std::chrono::duration<double, std::nano>(end - start).count() / iterations << " ns/post\n";
+}
+
+int main()
+{
+  // Number of the iterations
+  const size_t iterations = 10000000;
+  // A channel which accepts only the normal and higher posts
+  drlog.addChannel(0, std::make_shared<drLog::StdOutChannel>(drLog::LogLevel::LOG_LEVEL_NORMAL));
+
+  // A low post filtered at runtime
+  run("Filtered at runtime", iterations, [](size_t i)
+    {
+      drlog.msg("main", drLog::MsgLevel::MSG_L_LOW) << "Request " << i << " served in " << 0.25 * double(i) << " ms";
+    }
+  );
+  // A debug post stripped at compile time
+  run("Stripped at compile time", iterations, [](size_t i)
+    {
+      strippedPosts(i);
+    }
+  );
+  // The arguments of the stripped macros must not be evaluated
+  if(evaluations != 0)
+  {
+    std::cerr << "!!!--> The arguments of a stripped post were evaluated " << evaluations << " times <--!!!\n";
+    return 1;
+  }
+  std::cout << "The arguments of the stripped posts were not evaluated\n";
+  return 0;
+}
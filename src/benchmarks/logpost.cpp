@@ -0,0 +1,111 @@
+/**
+ * @file logpost.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Micro-benchmark of building log posts (time and heap allocations per post).
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "../headers/log/log.hpp"
+
+// Counting the heap allocations ----
+  // Number of the allocations
+  static std::atomic<size_t> allocations = 0;
+  // Replacing the global operators
+  [[gnu::noinline]] void* operator new(size_t size)
+  {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+  }
+  [[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+  [[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+/**
+ * @brief A channel that accepts everything but writes nothing (we only measure the post).
+ * 
+ */
+class NullChannel
+  :
+    public drLog::LogChannel
+{
+  public:
+    NullChannel() : drLog::LogChannel(drLog::LogLevel::LOG_LEVEL_DEBUG) {}
+    bool write(const drLog::LogRecord& record) override
+    {
+      // Touch the message so it can't be optimized away
+      bytes += record.className.size() + record.message.size();
+      return true;
+    }
+    size_t bytes = 0;
+};
+
+/**
+ * @brief Runs a benchmark and prints its results.
+ * 
+ * @tparam Fn Type of the benchmarked function.
+ * @param name Name of the benchmark.
+ * @param iterations Number of the iterations.
+ * @param fn The benchmarked function.
+ */
+template<typename Fn>
+void run(const std::string& name, size_t iterations, Fn&& fn)
+{
+  // Warm up (so the reusable buffers are allocated)
+  for(size_t i = 0; i < 1000; ++i) fn(i);
+  // Measure
+  size_t allocBefore = allocations.load();
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < iterations; ++i) fn(i);
+  auto end = std::chrono::steady_clock::now();
+  size_t allocCount = allocations.load() - allocBefore;
+  // Print the results
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  std::cout << name << ": " << ns << " ns/post, " << double(allocCount) / iterations << " allocations/post\n";
+}
+
+int main()
+{
+  // Number of the iterations
+  const size_t iterations = 2000000;
+  // The channel
+  auto channel = std::make_shared<NullChannel>();
+  drlog.addChannel(0, channel);
+
+  // A typical log line with the old way (stringstream, str() and copies by value)
+  run("std::stringstream (old LogPost)", iterations, [&](size_t i)
+    {
+      std::stringstream stream;
+      stream << "Request " << i << " served in " << 0.25 * i << " ms from " << "worker";
+      std::string className = "main";
+      std::string message = stream.str();
+      channel->bytes += std::string(className).size() + std::string(message).size();
+    }
+  );
+  // The same line with LogPost
+  run("LogPost", iterations, [&](size_t i)
+    {
+      drlog.info("main") << "Request " << i << " served in " << 0.25 * i << " ms from " << "worker";
+    }
+  );
+  // A post that no channel accepts
+  channel->logLevel(drLog::LogLevel::LOG_LEVEL_NORMAL);
+  run("LogPost (filtered out)", iterations, [&](size_t i)
+    {
+      drlog.debug("main") << "Request " << i << " served in " << 0.25 * i << " ms from " << "worker";
+    }
+  );
+  // Print the bytes (so nothing is optimized away)
+  std::cout << "(" << channel->bytes << " bytes)\n";
+  return 0;
+}
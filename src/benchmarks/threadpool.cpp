@@ -0,0 +1,150 @@
+/**
+ * @file threadpool.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Benchmark of the work-stealing ThreadPool against a single locked queue, with many short tasks and 1..N threads.
+ * @details Two workloads: the main thread enqueues every task ("external"), or a few root tasks enqueue
+ * the tasks from the workers ("fan-out"). Usage: threadpool [tasks] [max threads]
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <queue>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include "../headers/general/threadpool.hpp"
+
+/**
+ * @brief The earlier ThreadPool: one queue, one lock and one condition for every worker.
+ * 
+ */
+class SingleQueuePool
+{
+  public:
+    SingleQueuePool(size_t numThreads)
+    {
+      for (size_t i = 0; i < numThreads; ++i)
+      {
+        _workers.emplace_back([this]
+          {
+            while (true)
+            {
+              std::function<void()> task;
+              {
+                std::unique_lock<std::mutex> lock(_queueMutex);
+                _condition.wait(lock, [this] { return !_tasks.empty() || _stop; });
+                if (_stop && _tasks.empty()) return;
+                task = std::move(_tasks.front());
+                _tasks.pop();
+              }
+              task();
+            }
+          }
+        );
+      }
+    }
+    ~SingleQueuePool()
+    {
+      {
+        std::unique_lock<std::mutex> lock(_queueMutex);
+        _stop = true;
+      }
+      _condition.notify_all();
+      for (std::thread &worker : _workers) worker.join();
+    }
+    void enqueue(std::function<void()> task)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_queueMutex);
+        _tasks.push(std::move(task));
+      }
+      _condition.notify_one();
+    }
+
+  private:
+    std::vector<std::thread>                        _workers;
+    std::queue<std::function<void()>>               _tasks;
+    std::mutex                                      _queueMutex;
+    std::condition_variable                         _condition;
+    bool                                            _stop                       = false;
+};
+
+/**
+ * @brief A short task (a bit of work, so it is not only the queue what we measure).
+ * 
+ * @param done Counter of the finished tasks.
+ */
+inline void shortTask(std::atomic<size_t>& done)
+{
+  volatile size_t value = 0;
+  for(size_t i = 0; i < 50; ++i) value = value + i;
+  done.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Runs a workload on a pool and gives back the throughput.
+ * 
+ * @tparam Pool Type of the pool.
+ * @param threads Number of the threads.
+ * @param tasks Number of the tasks.
+ * @param fanOut Are the tasks enqueued by the workers.
+ * @return double Tasks per second.
+ */
+template<typename Pool>
+double run(size_t threads, size_t tasks, bool fanOut)
+{
+  std::atomic<size_t> done = 0;
+  Pool pool(threads);
+  auto start = std::chrono::steady_clock::now();
+  if(fanOut)
+  {
+    // Every root task enqueues its share of the tasks
+    size_t roots = threads * 4;
+    for(size_t root = 0; root < roots; ++root)
+    {
+      size_t share = tasks / roots + (root < tasks % roots ? 1 : 0);
+      pool.enqueue([&pool, &done, share]
+        {
+          for(size_t i = 0; i < share; ++i) pool.enqueue([&done] { shortTask(done); });
+        }
+      );
+    }
+  }
+  else
+  {
+    for(size_t i = 0; i < tasks; ++i) pool.enqueue([&done] { shortTask(done); });
+  }
+  // Wait for every task
+  while(done.load(std::memory_order_relaxed) < tasks) std::this_thread::yield();
+  auto end = std::chrono::steady_clock::now();
+  return double(tasks) / std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+  // Settings
+  size_t tasks = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  size_t maxThreads = argc > 2 ? std::stoul(argv[2]) : std::max<size_t>(1, std::thread::hardware_concurrency());
+  // Every thread count and workload
+  std::cout << "workload,threads,single_queue_tasks_per_s,threadpool_tasks_per_s\n";
+  for(bool fanOut : { false, true })
+  {
+    for(size_t threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2)
+    {
+      double single = run<SingleQueuePool>(threads, tasks, fanOut);
+      double stealing = run<ThreadPool>(threads, tasks, fanOut);
+      std::cout << (fanOut ? "fan-out" : "external") << "," << threads << "," << single << "," << stealing << std::endl;
+    }
+  }
+  return 0;
+}
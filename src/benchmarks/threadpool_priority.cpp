@@ -0,0 +1,106 @@
+/**
+ * @file threadpool_priority.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Benchmark of the latency of urgent tasks in the ThreadPool under a batch load.
+ * @details The workers are kept busy with long batch tasks, while short urgent tasks come periodically.
+ * The time from the enqueue to the start of the urgent tasks is measured with three setups: everything in the
+ * normal lane ("fifo"), the batch in the low lane and the urgent tasks in the high lane ("lanes"), and the same
+ * with one reserved worker ("reserved"). Usage: threadpool_priority [threads] [urgent tasks]
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#include "../headers/general/threadpool.hpp"
+
+/**
+ * @brief Busy work for a while.
+ * 
+ * @param duration The time.
+ */
+void spin(std::chrono::microseconds duration)
+{
+  auto end = std::chrono::steady_clock::now() + duration;
+  while(std::chrono::steady_clock::now() < end);
+}
+
+/**
+ * @brief Runs a setup and writes the latencies of its urgent tasks.
+ * 
+ * @param name Name of the setup.
+ * @param threads Number of the threads.
+ * @param reserved Number of the reserved workers.
+ * @param batch Priority of the batch tasks.
+ * @param urgent Priority of the urgent tasks.
+ * @param urgentTasks Number of the urgent tasks.
+ */
+void run(const std::string& name, size_t threads, size_t reserved, ThreadPool::Priority batch, ThreadPool::Priority urgent, size_t urgentTasks)
+{
+  ThreadPool pool(threads, reserved);
+  std::atomic<bool> stop = false;
+  std::mutex latencyMutex;
+  std::vector<double> latencies;
+  // Keep the queue full of batch tasks (1 ms each)
+  std::atomic<size_t> batchQueued = 0;
+  std::thread feeder([&]
+    {
+      while(!stop.load())
+      {
+        if(batchQueued.load() < threads * 8)
+        {
+          batchQueued.fetch_add(1);
+          pool.enqueue([&batchQueued] { spin(std::chrono::microseconds(1000)); batchQueued.fetch_sub(1); }, batch);
+        }
+        else std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  );
+  // The urgent tasks (one in every 2 ms)
+  std::atomic<size_t> urgentDone = 0;
+  for(size_t i = 0; i < urgentTasks; ++i)
+  {
+    auto enqueued = std::chrono::steady_clock::now();
+    pool.enqueue([&, enqueued]
+      {
+        double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - enqueued).count();
+        {
+          std::lock_guard<std::mutex> lock(latencyMutex);
+          latencies.push_back(latency);
+        }
+        urgentDone.fetch_add(1);
+      }, urgent
+    );
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  // Wait for the urgent tasks, then stop the batch
+  while(urgentDone.load() < urgentTasks) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  stop.store(true);
+  feeder.join();
+  // Percentiles
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double rank) { return latencies[std::min(latencies.size() - 1, size_t(rank * double(latencies.size())))]; };
+  std::cout << name << "," << threads << "," << percentile(0.5) << "," << percentile(0.99) << "," << latencies.back() << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  // Settings
+  size_t threads = argc > 1 ? std::stoul(argv[1]) : std::max<size_t>(2, std::thread::hardware_concurrency());
+  size_t urgentTasks = argc > 2 ? std::stoul(argv[2]) : 500;
+  // The setups
+  std::cout << "setup,threads,p50_us,p99_us,max_us\n";
+  run("fifo", threads, 0, ThreadPool::Priority::PRIORITY_NORMAL, ThreadPool::Priority::PRIORITY_NORMAL, urgentTasks);
+  run("lanes", threads, 0, ThreadPool::Priority::PRIORITY_LOW, ThreadPool::Priority::PRIORITY_HIGH, urgentTasks);
+  run("reserved", threads, 1, ThreadPool::Priority::PRIORITY_LOW, ThreadPool::Priority::PRIORITY_HIGH, urgentTasks);
+  return 0;
+}
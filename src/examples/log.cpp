@@ -27,8 +27,8 @@ int main()
   // Add some channels to the log
     // StdOutChannel - Writing on the screen -> Normal level = MSG and DBG are hidden
     drlog.addChannel(0, std::make_shared<drLog::StdOutChannel>(drLog::LogLevel::LOG_LEVEL_NORMAL));
-    // FileChannel - Writing into files -> Debug level = everything is visible
-    drlog.addChannel(1, std::make_shared<drLog::FileChannel>("logs/", drLog::LogLevel::LOG_LEVEL_DEBUG));
+    // FileChannel - Writing into files -> Debug level = everything is visible, timestamps with milliseconds
+    drlog.addChannel(1, std::make_shared<drLog::FileChannel>("logs/", drLog::LogLevel::LOG_LEVEL_DEBUG, "%Y-%m-%d %H:%M:%S.%L"));
     // JsonChannel - Puts a json string trough a callback function -> High level = only see the errors
     drlog.addChannel(2, std::make_shared<drLog::JsonChannel>([](std::string json){ std::cout << json << "\n"; }, drLog::LogLevel::LOG_LEVEL_HIGH));
 
@@ -38,6 +38,21 @@ int main()
   drlog.warning("main") << "This is a warning message.";
   drlog.error("main") << "This is an error message.";
   drlog.debug("main") << "This is a debug message.";
+  // Costly arguments can be lazy: the lambda only runs if a channel accepts the post
+  drlog.debug("main") << "A lazy argument: " << []{ return std::to_string(42); };
+  // Typed fields: the JsonChannel writes them as members, the text channels as key=value
+  drlog.error("main").field("latency_us", 123).field("ratio", 0.75).field("cached", false) << "This is an error message with fields.";
+  // Interned senders: the name is registered once, the posts don't copy it
+  drLog::Sender worker = drlog.sender("worker");
+  drlog.info(worker) << "This is an info message from an interned sender.";
+
+  // Asynchronous logging
+    // From now on a background thread writes the channels -> the callers don't wait for the files
+    drlog.startAsync(1024, drLog::AsyncOverflow::ASYNC_BLOCK);
+    drlog.info("main") << "This is an asynchronous info message.";
+    drlog.error("main") << "This is an asynchronous error message.";
+    // Wait until everything is written (the destructor of the log does it too)
+    drlog.flush();
   // Returning
   return 0;
 }
\ No newline at end of file
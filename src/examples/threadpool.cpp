@@ -11,6 +11,10 @@
 #include <iostream>
 #include <functional>
 #include <mutex>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "../headers/general/threadpool.hpp"
 
@@ -38,6 +42,39 @@ int main()
       }
     );
   }
+  // Submitting a task with arguments: its result comes back through a future
+  std::future<int> sum = threadpool.submit([](int a, int b) { return a + b; }, 40, 2);
+  // Move-only captures are fine too
+  std::unique_ptr<std::string> text = std::make_unique<std::string>("moved into the task");
+  std::future<size_t> length = threadpool.submit([text = std::move(text)]() { return text->size(); });
+  // An urgent task goes before the normal and low priority tasks
+  std::future<int> urgent = threadpool.submit(ThreadPool::Priority::PRIORITY_HIGH, [] { return 7; });
+  // Wait for the results (before locking the mutex, the other tasks need it)
+  int urgentResult = urgent.get();
+  int sumResult = sum.get();
+  size_t lengthResult = length.get();
+  {
+    // Lock the mutex
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // Write the results
+    std::cout << "40 + 2 = " << sumResult << ", length: " << lengthResult << ", urgent: " << urgentResult << "\n";
+  }
+  // Parallel loops: the range is cut into chunks, and the calling thread works too until the end
+  std::vector<double> values(1000000);
+  threadpool.parallelFor(size_t(0), values.size(), 0, [&values](size_t i) { values[i] = 0.5 * i; });
+  // Sum of the values (the chunks are reduced in order)
+  double total = threadpool.parallelReduce(size_t(0), values.size(), 0, 0.0,
+    [&values](size_t i) { return values[i]; },
+    [](double a, double b) { return a + b; }
+  );
+  {
+    // Lock the mutex
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // Write the sum
+    std::cout << "Sum of the values: " << total << "\n";
+  }
+  // Wait for every task of the pool
+  threadpool.waitIdle();
   // Returning
   return 0;
 }
\ No newline at end of file
@@ -16,6 +16,9 @@
 #include <ctime>
 #include <chrono>
 #include <format>
+#include <vector>
+#include <string_view>
+#include <limits>
 
 namespace Utils
 {
@@ -67,6 +70,367 @@ namespace Utils
       // Calling getTimeTInStr
       return getTimeTInStr(currentTime, dateTimeFormat);
     }
+    /**
+     * @brief A datetime format split into its strftime (strptime) parts and its fractions of the second.
+     * @details The fractions are '%L' (milliseconds, 3 digits), '%f' (microseconds, 6 digits) and '%N' (nanoseconds, 9 digits).
+     * The TimeStampFormatter and the TimeStampParser work on the same split.
+     * 
+     */
+    struct TimeStampLayout
+    {
+      // Structures ----
+        /**
+         * @brief A part of the format.
+         * 
+         */
+        struct Segment
+        {
+          std::string             format;                                         // The strftime (strptime) format of the part.
+          int                     digits;                                         // Digits of the fraction (0 if the part is for strftime).
+        };
+        /**
+         * @brief A fraction field in a datetime text.
+         * 
+         */
+        struct Fraction
+        {
+          size_t                  offset;                                         // Position of the field.
+          int                     digits;                                         // Number of the digits.
+        };
+
+      // Variables ----
+        std::string               format;                                         // The format of the datetime.
+        std::vector<Segment>      segments;                                       // Parts of the format.
+
+      // Functions ----
+        /**
+         * @brief Sets the format and splits it.
+         * 
+         * @param dateTimeFormat The format of the datetime.
+         */
+        void assign(const std::string& dateTimeFormat)
+        {
+          // Store the format
+          format = dateTimeFormat;
+          segments.clear();
+          // Split the format into strftime parts and fractions
+          std::string part;
+          for(size_t i = 0; i < format.size(); ++i)
+          {
+            // Simple character
+            if(format[i] != '%' || i + 1 >= format.size())
+            {
+              part += format[i];
+              continue;
+            }
+            // A specifier
+            char specifier = format[++i];
+            int digits = specifier == 'L' ? 3 : specifier == 'f' ? 6 : specifier == 'N' ? 9 : 0;
+            // It is for strftime
+            if(digits == 0)
+            {
+              part += '%';
+              part += specifier;
+              continue;
+            }
+            // It is a fraction, so we close the current part
+            if(!part.empty()) segments.push_back( { part, 0 } );
+            part.clear();
+            segments.push_back( { "", digits } );
+          }
+          // The last part
+          if(!part.empty()) segments.push_back( { part, 0 } );
+        }
+    };
+    /**
+     * @brief A datetime formatter which caches its result for the current second.
+     * @details Besides the strftime specifiers the format can contain fractions of the second:
+     * '%L' for milliseconds (3 digits), '%f' for microseconds (6 digits) and '%N' for nanoseconds (9 digits).
+     * The calendar conversion (localtime_r and strftime) runs only when the second changes,
+     * otherwise only the digits of the fractions are rewritten in the cached string.
+     * It is not thread-safe, every thread (or channel) should use its own formatter.
+     * 
+     */
+    class TimeStampFormatter
+    {
+      public:
+        // Construction ----
+          /**
+           * @brief Constructs a new TimeStampFormatter object.
+           * 
+           * @param dateTimeFormat The format of the datetime.
+           */
+          TimeStampFormatter(const std::string& dateTimeFormat = "%Y-%m-%d %H:%M:%S")
+          {
+            this->dateTimeFormat(dateTimeFormat);
+          }
+          /**
+           * @brief Destroys the TimeStampFormatter object.
+           * 
+           */
+          ~TimeStampFormatter() = default;
+
+        // Functions ----
+          /**
+           * @brief Formats a time point.
+           * 
+           * @param timePoint The time point we want in string.
+           * @return std::string_view The formatted datetime (valid until the next call).
+           */
+          std::string_view format(const std::chrono::system_clock::time_point& timePoint)
+          {
+            // Split the time into seconds and nanoseconds
+            auto sinceEpoch = timePoint.time_since_epoch();
+            auto seconds = std::chrono::floor<std::chrono::seconds>(sinceEpoch);
+            long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch - seconds).count();
+            // Render the calendar part only if the second has changed
+            std::time_t second = std::time_t(seconds.count());
+            if(second != _cachedSecond) _render(second);
+            // Rewrite the fractions
+            for(const TimeStampLayout::Fraction& fraction : _fractions)
+            {
+              // Drop the digits we don't need
+              long long value = nanoseconds;
+              for(int i = fraction.digits; i < 9; ++i) value /= 10;
+              // Write the digits from the end
+              for(int i = fraction.digits - 1; i >= 0; --i)
+              {
+                _text[fraction.offset + i] = char('0' + value % 10);
+                value /= 10;
+              }
+            }
+            return _text;
+          }
+          /**
+           * @brief Formats a time_t.
+           * 
+           * @param dateTime The datetime we want in string.
+           * @return std::string_view The formatted datetime (valid until the next call).
+           */
+          std::string_view format(const std::time_t& dateTime)
+          {
+            return format(std::chrono::system_clock::from_time_t(dateTime));
+          }
+
+        // Getters ----
+          /**
+           * @brief Gets the format of the datetime.
+           * 
+           * @return const std::string& The format of the datetime.
+           */
+          const std::string& dateTimeFormat() const
+          {
+            return _layout.format;
+          }
+
+        // Setters ----
+          /**
+           * @brief Sets the format of the datetime.
+           * 
+           * @param dateTimeFormat The new format of the datetime.
+           */
+          void dateTimeFormat(const std::string& dateTimeFormat)
+          {
+            // Store and split the format
+            _layout.assign(dateTimeFormat);
+            // The cache is not valid anymore
+            _cachedSecond = std::numeric_limits<std::time_t>::min();
+          }
+
+      private:
+        // Variables ----
+          TimeStampLayout           _layout;                                        // The split format of the datetime.
+          std::vector<TimeStampLayout::Fraction>  _fractions;                       // Fraction fields of the rendered text.
+          std::string               _text;                                          // The rendered text.
+          std::time_t               _cachedSecond;                                  // The second of the rendered text.
+
+        // Functions ----
+          /**
+           * @brief Renders the text for a new second.
+           * 
+           * @param second The second.
+           */
+          void _render(std::time_t second)
+          {
+            // Convert time to local time
+            tm localTime;
+            localtime_r(&second, &localTime);
+            // Render the parts
+            _text.clear();
+            _fractions.clear();
+            for(const TimeStampLayout::Segment& segment : _layout.segments)
+            {
+              // Reserve the place of the fraction
+              if(segment.digits)
+              {
+                _fractions.push_back( { _text.size(), segment.digits } );
+                _text.append(segment.digits, '0');
+                continue;
+              }
+              // Format the part
+              char buffer[100];
+              size_t length = strftime(buffer, sizeof(buffer), segment.format.c_str(), &localTime);
+              _text.append(buffer, length);
+            }
+            // Store the second
+            _cachedSecond = second;
+          }
+    };
+    /**
+     * @brief A datetime parser for the texts of the TimeStampFormatter (the same format, fractions included).
+     * @details The strftime parts are parsed with strptime and converted with mktime (local time, like the formatter).
+     * The consecutive timestamps of a log usually differ only in their fractions, so if the text is the same
+     * as the last one outside of the fractions, only the digits of the fractions are read.
+     * It is not thread-safe, every thread should use its own parser.
+     * 
+     */
+    class TimeStampParser
+    {
+      public:
+        // Construction ----
+          /**
+           * @brief Constructs a new TimeStampParser object.
+           * 
+           * @param dateTimeFormat The format of the datetime.
+           */
+          TimeStampParser(const std::string& dateTimeFormat = "%Y-%m-%d %H:%M:%S")
+          {
+            this->dateTimeFormat(dateTimeFormat);
+          }
+
+        // Functions ----
+          /**
+           * @brief Parses a datetime text.
+           * 
+           * @param text The text (exactly the datetime, nothing else).
+           * @param timePoint The parsed time point.
+           * @return true The text is parsed.
+           * @return false The text doesn't match the format.
+           */
+          bool parse(std::string_view text, std::chrono::system_clock::time_point& timePoint)
+          {
+            // The same second as the last text: only the fractions are read
+            long long nanoseconds = 0;
+            if(_valid && _sameSecond(text) && _readFractions(text, nanoseconds))
+            {
+              timePoint = _cachedTime + std::chrono::nanoseconds(nanoseconds);
+              return true;
+            }
+            // Parse the whole text (strptime needs a closing zero)
+            _valid = false;
+            _text.assign(text);
+            _fractions.clear();
+            tm localTime = {};
+            localTime.tm_isdst = -1;
+            const char* position = _text.c_str();
+            for(const TimeStampLayout::Segment& segment : _layout.segments)
+            {
+              // A strftime part
+              if(segment.digits == 0)
+              {
+                position = strptime(position, segment.format.c_str(), &localTime);
+                if(position == nullptr) return false;
+                continue;
+              }
+              // A fraction
+              size_t offset = size_t(position - _text.c_str());
+              if(offset + segment.digits > _text.size()) return false;
+              _fractions.push_back( { offset, segment.digits } );
+              position += segment.digits;
+            }
+            // Nothing can follow it
+            if(*position != 0 || !_readFractions(text, nanoseconds)) return false;
+            // Convert the local time
+            std::time_t second = mktime(&localTime);
+            if(second == -1) return false;
+            _cachedTime = std::chrono::system_clock::from_time_t(second);
+            _valid = true;
+            timePoint = _cachedTime + std::chrono::nanoseconds(nanoseconds);
+            return true;
+          }
+
+        // Getters ----
+          /**
+           * @brief Gets the format of the datetime.
+           * 
+           * @return const std::string& The format of the datetime.
+           */
+          const std::string& dateTimeFormat() const
+          {
+            return _layout.format;
+          }
+
+        // Setters ----
+          /**
+           * @brief Sets the format of the datetime.
+           * 
+           * @param dateTimeFormat The new format of the datetime.
+           */
+          void dateTimeFormat(const std::string& dateTimeFormat)
+          {
+            // Store and split the format
+            _layout.assign(dateTimeFormat);
+            // The cache is not valid anymore
+            _valid = false;
+          }
+
+      private:
+        // Variables ----
+          TimeStampLayout           _layout;                                        // The split format of the datetime.
+          std::vector<TimeStampLayout::Fraction>  _fractions;                       // Fraction fields of the last text.
+          std::string               _text;                                          // The last parsed text.
+          std::chrono::system_clock::time_point   _cachedTime;                      // The second of the last text.
+          bool                      _valid            = false;                      // Is the cache valid.
+
+        // Functions ----
+          /**
+           * @brief Checks if a text is the same as the last one outside of the fractions.
+           * 
+           * @param text The text.
+           * @return true It is the same second.
+           * @return false It has to be parsed.
+           */
+          bool _sameSecond(std::string_view text) const
+          {
+            if(text.size() != _text.size()) return false;
+            size_t start = 0;
+            for(const TimeStampLayout::Fraction& fraction : _fractions)
+            {
+              if(text.compare(start, fraction.offset - start, _text, start, fraction.offset - start) != 0) return false;
+              start = fraction.offset + fraction.digits;
+            }
+            return text.compare(start, std::string_view::npos, _text, start, std::string::npos) == 0;
+          }
+          /**
+           * @brief Reads the fractions of a text (the most precise one gives the nanoseconds).
+           * 
+           * @param text The text.
+           * @param nanoseconds The nanoseconds of the fractions.
+           * @return true The fractions are read.
+           * @return false A fraction has a non-digit character.
+           */
+          bool _readFractions(std::string_view text, long long& nanoseconds) const
+          {
+            int precision = 0;
+            for(const TimeStampLayout::Fraction& fraction : _fractions)
+            {
+              // Read the digits
+              long long value = 0;
+              for(int i = 0; i < fraction.digits; ++i)
+              {
+                char digit = text[fraction.offset + i];
+                if(digit < '0' || digit > '9') return false;
+                value = value * 10 + (digit - '0');
+              }
+              // Keep the most precise one
+              if(fraction.digits <= precision) continue;
+              precision = fraction.digits;
+              for(int i = fraction.digits; i < 9; ++i) value *= 10;
+              nanoseconds = value;
+            }
+            return true;
+          }
+    };
   }
 }
 
@@ -0,0 +1,187 @@
+/**
+ * @file ringbuffer.hpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief A bounded, lock-free, multi-producer multi-consumer ring buffer.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef _RINGBUFFER_HPP_
+#define _RINGBUFFER_HPP_
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace Utils
+{
+  /**
+   * @brief A bounded lock-free MPMC queue (based on Dmitry Vyukov's sequence-numbered cells).
+   * @details Every cell carries a sequence number which tells whether the cell is free for the
+   * producer of a given position or ready for the consumer of it. The data is not moved in and
+   * out of the cells: the producer fills the cell in place and the consumer reads it in place,
+   * so objects with their own storage (like std::string) keep their capacity between rounds.
+   * 
+   * @tparam T Type of the stored elements. Has to be default constructible.
+   */
+  template<typename T>
+  class RingBuffer
+  {
+    public:
+      // Construction ----
+        /**
+         * @brief Constructs a new RingBuffer object.
+         * 
+         * @param capacity Minimum number of the elements (rounded up to the next power of two).
+         */
+        RingBuffer(size_t capacity)
+        {
+          // Round the capacity up to a power of two (so we can mask instead of modulo)
+          size_t size = 2;
+          while(size < capacity) size <<= 1;
+          // Set the mask
+          _mask = size - 1;
+          // Allocate the cells
+          _cells = std::make_unique<Cell[]>(size);
+          // Every cell is free for the producer of its own position
+          for(size_t i = 0; i < size; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        /**
+         * @brief Destroys the RingBuffer object.
+         * 
+         */
+        ~RingBuffer() = default;
+        // Not copyable
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+      // Functions ----
+        /**
+         * @brief Tries to put an element into the buffer.
+         * 
+         * @tparam Fn Type of the fill function.
+         * @param fill A function with 'void(T&)' signature which fills the reserved cell.
+         * @return true The element has been added.
+         * @return false The buffer is full.
+         */
+        template<typename Fn>
+        bool tryPush(Fn&& fill)
+        {
+          // The cell we will fill
+          Cell* cell;
+          // Position of the producer
+          size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+          // Trying to reserve a cell
+          while(true)
+          {
+            // Get the cell of the position
+            cell = &_cells[pos & _mask];
+            // Check its sequence
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            // The cell is free for this position
+            if(diff == 0)
+            {
+              // Trying to step the position, if it succeeds the cell is ours
+              if(_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            // The cell is still used by the previous round -> the buffer is full
+            else if(diff < 0) return false;
+            // Another producer took it, reloading the position
+            else pos = _enqueuePos.load(std::memory_order_relaxed);
+          }
+          // Fill the cell
+          fill(cell->data);
+          // Publish it for the consumer
+          cell->sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+        /**
+         * @brief Tries to take an element from the buffer.
+         * 
+         * @tparam Fn Type of the consume function.
+         * @param consume A function with 'void(T&)' signature which processes the cell.
+         * @return true An element has been consumed.
+         * @return false The buffer is empty.
+         */
+        template<typename Fn>
+        bool tryPop(Fn&& consume)
+        {
+          // The cell we will consume
+          Cell* cell;
+          // Position of the consumer
+          size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+          // Trying to reserve a cell
+          while(true)
+          {
+            // Get the cell of the position
+            cell = &_cells[pos & _mask];
+            // Check its sequence
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            // The cell is filled for this position
+            if(diff == 0)
+            {
+              // Trying to step the position, if it succeeds the cell is ours
+              if(_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            // The cell hasn't been filled yet -> the buffer is empty
+            else if(diff < 0) return false;
+            // Another consumer took it, reloading the position
+            else pos = _dequeuePos.load(std::memory_order_relaxed);
+          }
+          // Consume the cell
+          consume(cell->data);
+          // Give back the cell to the producer of the next round
+          cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+          return true;
+        }
+
+      // Getters ----
+        /**
+         * @brief Gets the capacity of the buffer.
+         * 
+         * @return size_t The capacity of the buffer.
+         */
+        size_t capacity() const
+        {
+          return _mask + 1;
+        }
+        /**
+         * @brief Gets the approximate number of the elements in the buffer.
+         * 
+         * @return size_t The approximate number of the elements.
+         */
+        size_t size() const
+        {
+          // Get the positions
+          size_t enqueued = _enqueuePos.load(std::memory_order_relaxed);
+          size_t dequeued = _dequeuePos.load(std::memory_order_relaxed);
+          // They can be read in any order, so we don't go under zero
+          return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+    private:
+      // Structures ----
+        /**
+         * @brief A cell of the buffer.
+         * 
+         */
+        struct Cell
+        {
+          std::atomic<size_t>         sequence;                                       // Sequence number of the cell.
+          T                           data;                                           // The stored element.
+        };
+
+      // Variables ----
+        std::unique_ptr<Cell[]>       _cells;                                         // The cells of the buffer.
+        size_t                        _mask                       = 0;                // Mask for the positions (capacity - 1).
+        alignas(64) std::atomic<size_t>   _enqueuePos             = 0;                // Position of the producers.
+        alignas(64) std::atomic<size_t>   _dequeuePos             = 0;                // Position of the consumers.
+  };
+}
+
+#endif
@@ -14,6 +14,11 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <string_view>
+#include <cstdint>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
 
 namespace Utils
 {
@@ -91,6 +96,84 @@ namespace Utils
       // Return with the result
       return result;
     }
+    /**
+     * @brief Appends a text as the content of a JSON string (without the quotes).
+     * @details The output is the same what nlohmann::json::dump() gives: '"', '\\' and the control
+     * characters are escaped (\b, \f, \n, \r, \t or \u00xx), everything else is copied
+     * as it is. The clean runs are searched 16 bytes at once (with SSE2, if we have it) and copied in one piece.
+     * 
+     * @param output The string we append to.
+     * @param text The text we want to escape.
+     */
+    static void appendJsonEscaped(std::string& output, std::string_view text)
+    {
+      // The escape sequences of the control characters (0 means \u00xx)
+      static constexpr char shortEscapes[32] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 'b', 't', 'n', 0, 'f', 'r', 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      };
+      static constexpr char hexDigits[] = "0123456789abcdef";
+      // Start of the current clean run
+      const char* data = text.data();
+      size_t size = text.size();
+      size_t start = 0;
+      size_t pos = 0;
+      // Going through the text
+      while(pos < size)
+      {
+#if defined(__SSE2__)
+        // Skip the clean blocks (no quote, backslash or control character in them)
+        while(pos + 16 <= size)
+        {
+          __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+          // Control characters: min(block, 0x1F) == block (unsigned)
+          __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1F)), block);
+          __m128i quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+          __m128i backslash = _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'));
+          int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, backslash), control));
+          // Stop at the first special character
+          if(mask != 0)
+          {
+            pos += __builtin_ctz(unsigned(mask));
+            break;
+          }
+          pos += 16;
+        }
+#endif
+        // Find the next special character one by one (the tail, or everything without SSE2)
+        while(pos < size)
+        {
+          unsigned char c = static_cast<unsigned char>(data[pos]);
+          if(c < 0x20 || c == '"' || c == '\\') break;
+          ++pos;
+        }
+        // We reached the end
+        if(pos >= size) break;
+        unsigned char c = static_cast<unsigned char>(data[pos]);
+        // Copy the clean run
+        output.append(data + start, pos - start);
+        // Escape the character
+        if(c == '"' || c == '\\')
+        {
+          output.push_back('\\');
+          output.push_back(char(c));
+        }
+        else if(shortEscapes[c] != 0)
+        {
+          output.push_back('\\');
+          output.push_back(shortEscapes[c]);
+        }
+        else
+        {
+          char escape[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF] };
+          output.append(escape, sizeof(escape));
+        }
+        // The next run starts after it
+        start = ++pos;
+      }
+      // Copy the last clean run
+      output.append(data + start, size - start);
+    }
   }
 }
 
@@ -13,100 +13,1295 @@
 
 #include <iostream>
 #include <vector>
-#include <queue>
+#include <algorithm>
+#include <memory>
+#include <atomic>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <future>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <new>
+#include <semaphore>
+#include <exception>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <time.h>
 
 /**
  * @brief ThreadPool object implementation.
+ * @details Every worker has its own task deque (with its own lock), so the workers don't contend on one queue.
+ * The tasks enqueued by a worker go into its own deque, and it takes them from the back (the newest first,
+ * while its data is still in the cache). The tasks enqueued from outside are spread over the workers round-robin,
+ * and they are taken in their order (oldest first), so a pool with one worker runs them serially in order.
+ * A worker without tasks steals from the front of the others' deques (the oldest tasks), and sleeps only
+ * if every deque is empty. Every worker sleeps on its own flag, and a new task wakes up exactly one sleeping
+ * worker (the one of its deque if it sleeps), so the enqueue doesn't touch a shared lock at all.
+ * For the loops over big ranges there are parallelFor, parallelReduce and parallelTransform: they cut the range into chunks,
+ * and a few helper tasks and the calling thread take the chunks until the end of the loop.
+ * Every deque has a lane for every priority. A worker takes the highest priority task of the whole pool first (it steals it
+ * if its own deque has only lower ones), but a task of a lower lane that has waited for the aging limit of its lane (or reached
+ * its deadline) goes before them in any deque, so nothing starves.
+ * Some workers can be reserved for the high priority tasks, so they are never stuck behind long batch tasks.
+ * The number of the workers can be elastic (see SizingPolicy): the slots of the workers are allocated up front, a new worker
+ * is started when the backlog stays big, and the workers over the minimum retire after an idle timeout.
  * 
  */
 class ThreadPool
 {
   public:
-    // Construction ----
+    // Enumerators ----
       /**
-       * @brief Constructs a new ThreadPool object.
+       * @brief Priorities (lanes) of the tasks.
        * 
-       * @param numThreads Number of worker threads.
        */
-      ThreadPool(size_t numThreads)
+      enum class Priority : unsigned int
       {
-        // Going through all the worker threads
-        for (size_t i = 0; i < numThreads; ++i)
-        {
-          // Add a thread to the pool
-          _workers.emplace_back([this]
+        PRIORITY_HIGH = 0,
+        PRIORITY_NORMAL = 1,
+        PRIORITY_LOW = 2,
+      };
+
+    // Constants ----
+      static constexpr size_t                         PRIORITY_COUNT              = 3;                    // Number of the priorities.
+
+    // Structures ----
+      /**
+       * @brief How many workers the pool runs.
+       * @details The pool starts minWorkers workers. When the tasks waiting per worker reach backlogPerWorker, nobody sleeps,
+       * and it lasts for growDelayMs, a new worker is started (up to maxWorkers). It is checked at every enqueue
+       * and at the end of every task, so a backlog grows the pool without new enqueues too. A worker over the minimum retires
+       * after idleTimeoutMs without tasks (the last started one first, so they retire one by one).
+       * 
+       */
+      struct SizingPolicy
+      {
+        size_t                                    minWorkers        = 1;        // Workers always running.
+        size_t                                    maxWorkers        = 1;        // Most workers running at once.
+        size_t                                    reservedWorkers   = 0;        // Workers running only high priority tasks (from the minimal ones, at least one is left for the others).
+        size_t                                    backlogPerWorker  = 4;        // Waiting tasks per worker that count as backlog.
+        size_t                                    growDelayMs       = 10;       // The backlog has to last this long to start a new worker.
+        size_t                                    idleTimeoutMs     = 10000;    // A worker over the minimum retires after this idle time.
+        size_t                                    maxQueued         = 0;        // tryEnqueue() refuses the tasks when this many tasks wait (0 = no limit).
+      };
+      /**
+       * @brief Snapshot of the counters of a priority lane.
+       * @details The counters only grow (from the creation of the pool), except the depth.
+       * 
+       */
+      struct LaneStats
+      {
+        // Constants ----
+          static constexpr size_t WAIT_BUCKETS = 40;                              // Number of the buckets of the queue wait histogram.
+
+        // Variables ----
+          size_t                                    depth             = 0;        // Tasks waiting in the lane now.
+          uint64_t                                  enqueued          = 0;        // Tasks put into the lane.
+          uint64_t                                  started           = 0;        // Tasks taken from the lane to run.
+          uint64_t                                  promoted          = 0;        // Tasks taken before a higher lane (because of their age or deadline).
+          std::array<uint64_t, WAIT_BUCKETS>        queueWait         = {};       // Histogram of the times in the queue (see waitTiming()): bucket i counts [2^i, 2^(i+1)) ns.
+
+        // Functions ----
+          /**
+           * @brief Estimates a percentile of the times in the queue from the histogram.
+           * 
+           * @param rank The rank (e.g. 0.99).
+           * @return uint64_t The upper bound of the bucket of the percentile in nanoseconds (0 if nothing was measured).
+           */
+          uint64_t waitPercentile(double rank) const
+          {
+            // Number of the measurements
+            uint64_t count = 0;
+            for(uint64_t bucket : queueWait) count += bucket;
+            if(count == 0) return 0;
+            // Find the bucket of the rank
+            uint64_t target = uint64_t(rank * double(count));
+            uint64_t seen = 0;
+            for(size_t i = 0; i < WAIT_BUCKETS; ++i)
+            {
+              seen += queueWait[i];
+              if(seen > target) return uint64_t(2) << i;
+            }
+            return uint64_t(2) << (WAIT_BUCKETS - 1);
+          }
+      };
+
+    // Classes ----
+      /**
+       * @brief A move-only, type-erased task of the ThreadPool.
+       * @details The callables up to INLINE_SIZE bytes (and nothrow movable) are stored in the task itself,
+       * so a typical lambda (a few pointers, a std::promise, a std::unique_ptr...) doesn't allocate.
+       * The bigger ones are moved to the heap. Unlike std::function, move-only callables are accepted.
+       * 
+       */
+      class Task
+      {
+        public:
+          // Constants ----
+            static constexpr size_t                         INLINE_SIZE                 = 56;                   // Size of the inline buffer (the task is 64 bytes).
+
+          // Construction ----
+            /**
+             * @brief Constructs an empty Task object.
+             * 
+             */
+            Task() = default;
+            /**
+             * @brief Constructs a new Task object from a callable.
+             * 
+             * @tparam F Type of the callable (called without arguments).
+             * @param function The callable.
+             */
+            template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task> && std::is_invocable_v<std::decay_t<F>&>>>
+            Task(F&& function)
             {
-              // Run a cycle
-              while (true)
+              using Function = std::decay_t<F>;
+              // Empty std::function (or function pointer) gives an empty task
+              if constexpr (std::is_constructible_v<bool, const Function&>)
               {
-                // The task
-                std::function<void()> task;
-                {
-                  // Lock the queue
-                  std::unique_lock<std::mutex> lock(_queueMutex);
-                  // Waiting for a task
-                  _condition.wait(lock, [this] { return !_tasks.empty() || _stop; });
-                  // If stop and no more tasks
-                  if (_stop && _tasks.empty())
-                    // Retrun
-                    return;
-                  // Get the task
-                  task = std::move(_tasks.front());
-                  _tasks.pop();
-                }
-                // Run the task
-                task();
+                if(!bool(function)) return;
+              }
+              // Small callables are stored inline, the others on the heap
+              if constexpr (_fitsInline<Function>())
+              {
+                ::new (static_cast<void*>(_buffer)) Function(std::forward<F>(function));
+                _operations = &_inlineOperations<Function>;
+              }
+              else
+              {
+                ::new (static_cast<void*>(_buffer)) Function*(new Function(std::forward<F>(function)));
+                _operations = &_heapOperations<Function>;
               }
             }
-          );
-        }
+            /**
+             * @brief Moves a Task object.
+             * 
+             * @param other The moved task.
+             */
+            Task(Task&& other) noexcept
+            {
+              _moveFrom(other);
+            }
+            /**
+             * @brief Move assignment.
+             * 
+             * @param other The moved task.
+             * @return Task& The task itself.
+             */
+            Task& operator=(Task&& other) noexcept
+            {
+              if(this == &other) return *this;
+              _reset();
+              _moveFrom(other);
+              return *this;
+            }
+            /**
+             * @brief Clears the task.
+             * 
+             * @return Task& The task itself.
+             */
+            Task& operator=(std::nullptr_t) noexcept
+            {
+              _reset();
+              return *this;
+            }
+            /**
+             * @brief Destroys the Task object.
+             * 
+             */
+            ~Task()
+            {
+              _reset();
+            }
+            Task(const Task&) = delete;
+            Task& operator=(const Task&) = delete;
+
+          // Operators ----
+            /**
+             * @brief Runs the task.
+             * 
+             */
+            void operator()()
+            {
+              _operations->invoke(_buffer);
+            }
+            /**
+             * @brief Checks if the task has a callable.
+             * 
+             * @return true It has a callable.
+             * @return false It is empty.
+             */
+            explicit operator bool() const
+            {
+              return _operations != nullptr;
+            }
+
+        private:
+          // Structures ----
+            /**
+             * @brief The type specific operations of a stored callable.
+             * 
+             */
+            struct Operations
+            {
+              void                                          (*invoke)(void*);                                   // Calls the callable.
+              void                                          (*move)(void*, void*) noexcept;                     // Moves the callable into an empty buffer (and destroys the old one).
+              void                                          (*destroy)(void*) noexcept;                         // Destroys the callable.
+            };
+
+          // Variables ----
+            alignas(std::max_align_t) unsigned char         _buffer[INLINE_SIZE];                               // The inline callable (or the pointer of the heap one).
+            const Operations*                               _operations                 = nullptr;              // Operations of the callable (nullptr = empty).
+
+          // Functions ----
+            /**
+             * @brief Checks if a callable type can be stored inline.
+             * 
+             * @tparam F Type of the callable.
+             * @return true It fits into the buffer.
+             * @return false It goes to the heap.
+             */
+            template<typename F>
+            static constexpr bool _fitsInline()
+            {
+              return sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+            }
+            // Operations of the inline callables
+            template<typename F>
+            static constexpr Operations _inlineOperations = {
+              [](void* buffer) { (*std::launder(static_cast<F*>(buffer)))(); },
+              [](void* to, void* from) noexcept
+              {
+                F* function = std::launder(static_cast<F*>(from));
+                ::new (to) F(std::move(*function));
+                function->~F();
+              },
+              [](void* buffer) noexcept { std::launder(static_cast<F*>(buffer))->~F(); }
+            };
+            // Operations of the heap callables (the buffer holds the pointer)
+            template<typename F>
+            static constexpr Operations _heapOperations = {
+              [](void* buffer) { (**std::launder(static_cast<F**>(buffer)))(); },
+              [](void* to, void* from) noexcept { ::new (to) F*(*std::launder(static_cast<F**>(from))); },
+              [](void* buffer) noexcept { delete *std::launder(static_cast<F**>(buffer)); }
+            };
+            /**
+             * @brief Takes the callable of another task.
+             * 
+             * @param other The other task.
+             */
+            void _moveFrom(Task& other) noexcept
+            {
+              if(!other._operations) return;
+              other._operations->move(_buffer, other._buffer);
+              _operations = other._operations;
+              other._operations = nullptr;
+            }
+            /**
+             * @brief Destroys the callable.
+             * 
+             */
+            void _reset() noexcept
+            {
+              if(!_operations) return;
+              _operations->destroy(_buffer);
+              _operations = nullptr;
+            }
+      };
+
+    // Construction ----
+      /**
+       * @brief Constructs a new ThreadPool object.
+       * 
+       * @param numThreads Number of worker threads.
+       * @param reservedWorkers Number of the workers running only high priority tasks (at least one worker is left for the others).
+       */
+      ThreadPool(size_t numThreads, size_t reservedWorkers = 0)
+        : ThreadPool(SizingPolicy{ numThreads, numThreads, reservedWorkers })
+      {
+      }
+      /**
+       * @brief Constructs a new ThreadPool object with an elastic number of workers.
+       * 
+       * @param policy How many workers the pool runs.
+       */
+      ThreadPool(const SizingPolicy& policy)
+        : _policy(policy)
+      {
+        // At least one worker is needed to run the tasks
+        _policy.maxWorkers = std::max<size_t>(1, _policy.maxWorkers);
+        _policy.minWorkers = std::clamp<size_t>(_policy.minWorkers, 1, _policy.maxWorkers);
+        _reserved = std::min(_policy.reservedWorkers, _policy.minWorkers - 1);
+        _policy.reservedWorkers = _reserved;
+        // The deques and slots of every possible worker (allocated before the threads start, so they never move)
+        for (size_t i = 0; i < _policy.maxWorkers; ++i) _queues.push_back(std::make_unique<WorkerQueue>());
+        _workers.resize(_policy.maxWorkers);
+        // Start the minimal workers
+        for (size_t i = 0; i < _policy.minWorkers; ++i) _workers[i] = std::thread(&ThreadPool::_workerLoop, this, i);
+        _active.store(_policy.minWorkers);
       }
       /**
        * @brief Destroys the ThreadPool object.
+       * @details The tasks already in the queues are still run.
        * 
        */
       ~ThreadPool()
       {
         // Stop the queue
+        _stop.store(true);
+        // Wait for a starting worker (no worker starts after this)
         {
-          std::unique_lock<std::mutex> lock(_queueMutex);
-          _stop = true;
+          std::lock_guard<std::mutex> lock(_resizeMutex);
         }
         // Wake up all the threads
-        _condition.notify_all();
-        // Join them and wait for their ends
+        for (size_t i = 0; i < _queues.size(); ++i) _wakeUp(i, true, true);
+        // Join them and wait for their ends (the retired ones too)
         for (std::thread &worker : _workers)
-          worker.join();
+          if(worker.joinable()) worker.join();
       }
+      ThreadPool(const ThreadPool&) = delete;
+      ThreadPool& operator=(const ThreadPool&) = delete;
 
     // Functions ----
       /**
        * @brief Adds new task to the queue.
+       * @details From a worker of this pool the task goes into the worker's own deque,
+       * otherwise into the deque of the next worker (round-robin). The tasks below high priority skip the reserved workers.
+       * A task is taken before the higher lanes when it has waited for the aging limit of its lane, or its deadline has come
+       * (so the deadline should be a bit earlier than the real limit). These times are checked with the coarse monotonic clock,
+       * so they are a few milliseconds late at most.
        * 
        * @param task The task we want to add.
+       * @param priority Priority of the task.
+       * @param deadline Time point until the task should be started (max = no deadline).
+       */
+      void enqueue(Task task, Priority priority = Priority::PRIORITY_NORMAL, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
+      {
+        // Nothing to run
+        if(!task) return;
+        size_t lane = std::min<size_t>(size_t(priority), PRIORITY_COUNT - 1);
+        bool high = lane == 0;
+        // Choose the deque (a reserved worker keeps only the high priority tasks)
+        size_t index;
+        if(_tlsPool == this && (high || _tlsIndex >= _reserved)) index = _tlsIndex;
+        else
+        {
+          size_t first = high ? 0 : _reserved;
+          index = first + _nextQueue.fetch_add(1, std::memory_order_relaxed) % (_active.load(std::memory_order_relaxed) - first);
+        }
+        // Counted until it is finished (for waitIdle())
+        _unfinished.fetch_add(1);
+        // When the task goes before the higher lanes
+        int64_t aging = _agingLimits[lane].load(std::memory_order_relaxed);
+        int64_t urgentAt = std::min(_toNanoseconds(deadline), aging > 0 ? _coarseNow() + aging : std::numeric_limits<int64_t>::max());
+        // The precise time only for the queue wait histogram
+        int64_t enqueuedAt = _waitTiming.load(std::memory_order_relaxed) ? _now() : 0;
+        // Adds the task to the deque
+        {
+          WorkerQueue& queue = *_queues[index];
+          std::lock_guard<std::mutex> lock(queue.mutex);
+          queue.lanes[lane].push_back(QueuedTask{ std::move(task), enqueuedAt, urgentAt, _tlsPool == this && _tlsIndex == index });
+          queue.sizes[lane].store(queue.lanes[lane].size(), std::memory_order_relaxed);
+          queue.counters[lane].enqueued.fetch_add(1, std::memory_order_relaxed);
+          // Counted before the lock is released, so a thief can't take it before it is counted
+          _lanePending[lane].fetch_add(1);
+          _pending.fetch_add(1);
+        }
+        // Wakes up a thread (if one sleeps)
+        _wakeUp(index, false, high);
+        // Start a new worker if the backlog stays big
+        if(_active.load(std::memory_order_relaxed) < _policy.maxWorkers) _grow();
+      }
+      /**
+       * @brief Adds new task to the queue, unless the pool is saturated.
+       * @details The task is refused if SizingPolicy::maxQueued tasks wait already, or drain() runs
+       * (then only the tasks of the pool's own workers are accepted, so the drain can finish).
+       * 
+       * @param task The task we want to add (it is moved only if it is accepted).
+       * @param priority Priority of the task.
+       * @param deadline Time point until the task should be started (max = no deadline).
+       * @return true The task is added.
+       * @return false The pool is saturated (or drained), the task is left untouched.
+       */
+      bool tryEnqueue(Task&& task, Priority priority = Priority::PRIORITY_NORMAL, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
+      {
+        // Saturated
+        if(_policy.maxQueued > 0 && _pending.load(std::memory_order_relaxed) >= _policy.maxQueued) return false;
+        // Drained
+        if(_draining.load() > 0 && _tlsPool != this) return false;
+        enqueue(std::move(task), priority, deadline);
+        return true;
+      }
+      /**
+       * @brief Waits until every task is finished (the queues are empty and no task runs).
+       * @details New tasks can come meanwhile, so under a steady flow of tasks it may wait long (see drain()).
+       * It can't be called from a task of the pool (the task itself would never finish).
+       * 
+       * @return true Every task is finished.
+       * @return false Called from a task of the pool.
+       */
+      bool waitIdle()
+      {
+        // A task of the pool would wait for itself
+        if(_tlsPool == this)
+        {
+          std::cerr << "!!!--> waitIdle() can't be called from a task of the pool <--!!!\n";
+          return false;
+        }
+        // The last finished task wakes us up
+        size_t unfinished;
+        while((unfinished = _unfinished.load()) != 0) _unfinished.wait(unfinished);
+        return true;
+      }
+      /**
+       * @brief Waits until every task is finished, while tryEnqueue() refuses the tasks from outside of the pool.
+       * @details The tasks of the running tasks are still accepted, so the work in progress can finish. enqueue() is never refused.
+       * 
+       * @return true Every task is finished.
+       * @return false Called from a task of the pool.
+       */
+      bool drain()
+      {
+        _draining.fetch_add(1);
+        bool result = waitIdle();
+        _draining.fetch_sub(1);
+        return result;
+      }
+      /**
+       * @brief Adds a callable with its arguments to the queue, and gives back the future of its result.
+       * @details The callable and the arguments are moved (or copied) into the task, move-only ones are fine too.
+       * If the callable throws, the exception is stored in the future.
+       * 
+       * @tparam F Type of the callable.
+       * @tparam Args Type of the arguments.
+       * @param function The callable.
+       * @param args The arguments.
+       * @return std::future<R> The future of the result.
+       */
+      template<typename F, typename... Args>
+      auto submit(F&& function, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+      {
+        return submit(Priority::PRIORITY_NORMAL, std::forward<F>(function), std::forward<Args>(args)...);
+      }
+      /**
+       * @brief Adds a callable with its arguments to a priority lane, and gives back the future of its result.
+       * 
+       * @tparam F Type of the callable.
+       * @tparam Args Type of the arguments.
+       * @param priority Priority of the task.
+       * @param function The callable.
+       * @param args The arguments.
+       * @return std::future<R> The future of the result.
+       */
+      template<typename F, typename... Args>
+      auto submit(Priority priority, F&& function, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+      {
+        using Result = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        std::promise<Result> promise;
+        std::future<Result> future = promise.get_future();
+        enqueue([promise = std::move(promise), function = std::forward<F>(function), ...args = std::forward<Args>(args)]() mutable
+          {
+            try
+            {
+              if constexpr (std::is_void_v<Result>)
+              {
+                std::invoke(std::move(function), std::move(args)...);
+                promise.set_value();
+              }
+              else promise.set_value(std::invoke(std::move(function), std::move(args)...));
+            }
+            catch(...)
+            {
+              promise.set_exception(std::current_exception());
+            }
+          }, priority
+        );
+        return future;
+      }
+
+    // Parallel loops ----
+      /**
+       * @brief Calls a function for every index of a range, and waits for the end.
+       * @details The range is cut into chunks of grain indexes, and the chunks are handed out through an atomic counter:
+       * a few helper tasks (at most one per worker) and the calling thread take them until none is left,
+       * so a loop of millions of indexes costs only a handful of queue operations. The calling thread works too,
+       * so it can be called from a task of the same pool. If a call throws, the remaining chunks are skipped,
+       * and the first exception is rethrown here.
+       * 
+       * @tparam B Type of the first index (integral).
+       * @tparam E Type of the end index (integral).
+       * @tparam F Type of the function (called with an index).
+       * @param begin The first index.
+       * @param end The end of the range (exclusive).
+       * @param grain Number of the indexes in a chunk (0 = automatic, about four chunks per thread).
+       * @param function The function.
+       */
+      template<typename B, typename E, typename F>
+      void parallelFor(B begin, E end, size_t grain, F&& function)
+      {
+        using Index = std::common_type_t<B, E>;
+        static_assert(std::is_integral_v<Index>, "parallelFor needs integral indexes");
+        // Nothing to do
+        if(!(Index(begin) < Index(end))) return;
+        size_t count = size_t(Index(end) - Index(begin));
+        grain = _grainSize(count, grain);
+        // Every chunk runs its indexes one after the other
+        auto chunkFunction = [&](size_t chunk)
+        {
+          size_t last = std::min(count, (chunk + 1) * grain);
+          for(size_t i = chunk * grain; i < last; ++i) function(Index(Index(begin) + Index(i)));
+        };
+        _runChunks((count + grain - 1) / grain, chunkFunction);
+      }
+      /**
+       * @brief Maps every index of a range to a value, and reduces the values into one.
+       * @details Every chunk is reduced on its own (starting with the identity), then the results of the chunks
+       * are reduced in the order of the chunks, so the reduce doesn't have to be commutative (only associative).
+       * The chunks are handed out like in parallelFor.
+       * 
+       * @tparam B Type of the first index (integral).
+       * @tparam E Type of the end index (integral).
+       * @tparam T Type of the value.
+       * @tparam Map Type of the map (index -> value).
+       * @tparam Reduce Type of the reduce (value, value -> value).
+       * @param begin The first index.
+       * @param end The end of the range (exclusive).
+       * @param grain Number of the indexes in a chunk (0 = automatic, about four chunks per thread).
+       * @param identity The starting value (it doesn't change the result of the reduce).
+       * @param map The map.
+       * @param reduce The reduce.
+       * @return T The reduced value.
+       */
+      template<typename B, typename E, typename T, typename Map, typename Reduce>
+      T parallelReduce(B begin, E end, size_t grain, T identity, Map&& map, Reduce&& reduce)
+      {
+        using Index = std::common_type_t<B, E>;
+        static_assert(std::is_integral_v<Index>, "parallelReduce needs integral indexes");
+        // Nothing to do
+        if(!(Index(begin) < Index(end))) return identity;
+        size_t count = size_t(Index(end) - Index(begin));
+        grain = _grainSize(count, grain);
+        size_t chunks = (count + grain - 1) / grain;
+        // The results of the chunks (in a struct, so a vector<bool> doesn't share bits between the threads)
+        struct Partial { T value; };
+        std::vector<Partial> partials(chunks, Partial{ identity });
+        auto chunkFunction = [&](size_t chunk)
+        {
+          size_t last = std::min(count, (chunk + 1) * grain);
+          T value = identity;
+          for(size_t i = chunk * grain; i < last; ++i) value = reduce(std::move(value), map(Index(Index(begin) + Index(i))));
+          partials[chunk].value = std::move(value);
+        };
+        _runChunks(chunks, chunkFunction);
+        // Reduce the chunks in order
+        T result = std::move(identity);
+        for(Partial& partial : partials) result = reduce(std::move(result), std::move(partial.value));
+        return result;
+      }
+      /**
+       * @brief Writes the function of every element of a range into an output range, and waits for the end.
+       * @details The chunks are handed out like in parallelFor. The output can be the input range itself.
+       * 
+       * @tparam InputIt Type of the input iterator (random access).
+       * @tparam OutputIt Type of the output iterator (random access).
+       * @tparam F Type of the function (element -> output element).
+       * @param first The first element.
+       * @param last The end of the input range.
+       * @param output The first element of the output range (as big as the input).
+       * @param grain Number of the elements in a chunk (0 = automatic, about four chunks per thread).
+       * @param function The function.
+       * @return OutputIt The end of the output range.
+       */
+      template<typename InputIt, typename OutputIt, typename F>
+      OutputIt parallelTransform(InputIt first, InputIt last, OutputIt output, size_t grain, F&& function)
+      {
+        // Nothing to do
+        if(!(first < last)) return output;
+        size_t count = size_t(last - first);
+        grain = _grainSize(count, grain);
+        auto chunkFunction = [&](size_t chunk)
+        {
+          size_t end = std::min(count, (chunk + 1) * grain);
+          for(size_t i = chunk * grain; i < end; ++i) output[i] = function(first[i]);
+        };
+        _runChunks((count + grain - 1) / grain, chunkFunction);
+        return output + count;
+      }
+
+    // Getters ----
+      /**
+       * @brief Gets the number of the running worker threads.
+       * 
+       * @return size_t Number of the workers.
+       */
+      size_t size() const
+      {
+        return _active.load(std::memory_order_relaxed);
+      }
+      /**
+       * @brief Gets the sizing policy of the pool (with the corrected values).
+       * 
+       * @return const SizingPolicy& The policy.
        */
-      void enqueue(std::function<void()> task)
+      const SizingPolicy& policy() const
       {
-        // Adds the task to the queue
+        return _policy;
+      }
+      /**
+       * @brief Gets the number of the tasks waiting in the queues.
+       * 
+       * @return size_t Number of the waiting tasks.
+       */
+      size_t pending() const
+      {
+        return _pending.load(std::memory_order_relaxed);
+      }
+      /**
+       * @brief Gets the number of the workers reserved for the high priority tasks.
+       * 
+       * @return size_t Number of the reserved workers.
+       */
+      size_t reserved() const
+      {
+        return _reserved;
+      }
+      /**
+       * @brief Gets the counters of a priority lane (summed over the workers).
+       * 
+       * @param priority The priority.
+       * @return LaneStats The counters.
+       */
+      LaneStats laneStats(Priority priority) const
+      {
+        size_t lane = std::min<size_t>(size_t(priority), PRIORITY_COUNT - 1);
+        LaneStats stats;
+        for(const std::unique_ptr<WorkerQueue>& queue : _queues)
         {
-          std::unique_lock<std::mutex> lock(_queueMutex);
-          _tasks.push(std::move(task));
+          const LaneCounters& counters = queue->counters[lane];
+          stats.depth += queue->sizes[lane].load(std::memory_order_relaxed);
+          stats.enqueued += counters.enqueued.load(std::memory_order_relaxed);
+          stats.started += counters.started.load(std::memory_order_relaxed);
+          stats.promoted += counters.promoted.load(std::memory_order_relaxed);
+          for(size_t i = 0; i < LaneStats::WAIT_BUCKETS; ++i) stats.queueWait[i] += counters.queueWait[i].load(std::memory_order_relaxed);
         }
-        // Wakes up a thread
-        _condition.notify_one();
+        return stats;
+      }
+      /**
+       * @brief Gets the aging limit of a priority lane.
+       * 
+       * @param priority The priority.
+       * @return std::chrono::nanoseconds The waiting time after its tasks go before the higher lanes (0 = never).
+       */
+      std::chrono::nanoseconds agingLimit(Priority priority) const
+      {
+        return std::chrono::nanoseconds(_agingLimits[std::min<size_t>(size_t(priority), PRIORITY_COUNT - 1)].load(std::memory_order_relaxed));
+      }
+      /**
+       * @brief Gets if the times in the queue are measured.
+       * 
+       * @return true The times are measured.
+       * @return false Only the counters work.
+       */
+      bool waitTiming() const
+      {
+        return _waitTiming.load();
+      }
+
+    // Setters ----
+      /**
+       * @brief Sets the aging limit of a priority lane (it applies to the tasks enqueued later).
+       * 
+       * @param priority The priority.
+       * @param limit The waiting time after its tasks go before the higher lanes (0 = never).
+       */
+      void agingLimit(Priority priority, std::chrono::nanoseconds limit)
+      {
+        _agingLimits[std::min<size_t>(size_t(priority), PRIORITY_COUNT - 1)].store(std::max<int64_t>(0, int64_t(limit.count())), std::memory_order_relaxed);
+      }
+      /**
+       * @brief Switches the measurement of the times in the queue (the queueWait histograms of the lanes).
+       * @details The counters are always on, the times cost two precise clock reads per task, so they are off by default.
+       * 
+       * @param enabled Should we measure the times.
+       */
+      void waitTiming(bool enabled)
+      {
+        _waitTiming.store(enabled);
       }
 
   private:
+    // Structures ----
+      /**
+       * @brief A task in a deque with its times.
+       * 
+       */
+      struct QueuedTask
+      {
+        Task                                          task;                                               // The task.
+        int64_t                                       enqueuedAt                  = 0;                    // Time of the enqueue (steady clock, ns; 0 = not measured).
+        int64_t                                       urgentAt                    = 0;                    // The task goes before the higher lanes from this time (steady clock, ns).
+        bool                                          local                       = false;                // Enqueued by the owner worker of the deque (taken newest first).
+      };
+      /**
+       * @brief A growing ring of tasks (it keeps its capacity, so a busy pool doesn't allocate for its queues).
+       * 
+       */
+      struct TaskDeque
+      {
+        std::vector<QueuedTask>                       ring;                                               // The tasks (power of two size).
+        size_t                                        head                        = 0;                    // Position of the first task.
+        size_t                                        count                       = 0;                    // Number of the tasks.
+        /**
+         * @brief Gets the number of the tasks.
+         * 
+         * @return size_t Number of the tasks.
+         */
+        size_t size() const
+        {
+          return count;
+        }
+        /**
+         * @brief Checks if there is no task.
+         * 
+         * @return true No task.
+         * @return false We have tasks.
+         */
+        bool empty() const
+        {
+          return count == 0;
+        }
+        /**
+         * @brief Gets the task at the front.
+         * 
+         * @return const QueuedTask& The task.
+         */
+        const QueuedTask& front() const
+        {
+          return ring[head];
+        }
+        /**
+         * @brief Gets the task at the back.
+         * 
+         * @return const QueuedTask& The task.
+         */
+        const QueuedTask& back() const
+        {
+          return ring[(head + count - 1) & (ring.size() - 1)];
+        }
+        /**
+         * @brief Puts a task to the back.
+         * 
+         * @param task The task.
+         */
+        void push_back(QueuedTask&& task)
+        {
+          // Double the ring if it is full (the tasks keep their order)
+          if(count == ring.size())
+          {
+            std::vector<QueuedTask> bigger(std::max<size_t>(16, ring.size() * 2));
+            for(size_t i = 0; i < count; ++i) bigger[i] = std::move(ring[(head + i) & (ring.size() - 1)]);
+            ring = std::move(bigger);
+            head = 0;
+          }
+          ring[(head + count) & (ring.size() - 1)] = std::move(task);
+          ++count;
+        }
+        /**
+         * @brief Takes the task from the back.
+         * 
+         * @return QueuedTask The task.
+         */
+        QueuedTask pop_back()
+        {
+          --count;
+          return std::move(ring[(head + count) & (ring.size() - 1)]);
+        }
+        /**
+         * @brief Takes the task from the front.
+         * 
+         * @return QueuedTask The task.
+         */
+        QueuedTask pop_front()
+        {
+          QueuedTask task = std::move(ring[head]);
+          head = (head + 1) & (ring.size() - 1);
+          --count;
+          return task;
+        }
+      };
+      /**
+       * @brief The counters of a lane of a worker.
+       * 
+       */
+      struct LaneCounters
+      {
+        std::atomic<uint64_t>                         enqueued                    = 0;                    // Tasks put into the lane of the deque.
+        std::atomic<uint64_t>                         started                     = 0;                    // Tasks of the lane taken by the worker.
+        std::atomic<uint64_t>                         promoted                    = 0;                    // Tasks of the lane taken by the worker before a higher lane.
+        std::array<std::atomic<uint64_t>, LaneStats::WAIT_BUCKETS>  queueWait     = {};                   // Histogram of the times in the queue.
+      };
+      /**
+       * @brief The task deque of a worker (on its own cache line, so the workers don't disturb each other).
+       * 
+       */
+      struct alignas(64) WorkerQueue
+      {
+        std::mutex                                    mutex;                                              // Lock of the deque.
+        std::array<TaskDeque, PRIORITY_COUNT>         lanes;                                              // The tasks by priority.
+        std::array<std::atomic<size_t>, PRIORITY_COUNT>  sizes                    = {};                   // Number of the tasks by priority (read without the lock by the thieves).
+        std::atomic<uint32_t>                         sleeping                    = 0;                    // The worker sleeps (1) until somebody clears it.
+        std::binary_semaphore                         wakeSignal{ 0 };                                    // Released by the one who has cleared the sleeping flag.
+        alignas(64) std::array<LaneCounters, PRIORITY_COUNT>  counters;                                   // Counters of the lanes (written mostly by the worker).
+      };
+      /**
+       * @brief The shared state of a parallel loop (the helper tasks hold it, so a late helper never touches a finished loop).
+       * 
+       */
+      struct LoopState
+      {
+        std::atomic<size_t>                           next                        = 0;                    // The next chunk to take.
+        std::atomic<size_t>                           done                        = 0;                    // Number of the finished (or skipped) chunks.
+        std::atomic<bool>                             failed                      = false;                // A chunk has thrown, the rest are skipped.
+        size_t                                        chunks                      = 0;                    // Number of the chunks.
+        void                                          (*run)(void*, size_t)       = nullptr;              // Runs a chunk of the loop.
+        void*                                         loop                        = nullptr;              // The chunk function of the loop (on the stack of the caller).
+        std::mutex                                    errorMutex;                                         // Lock of the error.
+        std::exception_ptr                            error;                                              // The first exception.
+        /**
+         * @brief Takes and runs chunks until none is left.
+         * 
+         */
+        void work()
+        {
+          size_t chunk;
+          while((chunk = next.fetch_add(1)) < chunks)
+          {
+            // Run the chunk (unless an other one has already failed)
+            if(!failed.load(std::memory_order_relaxed))
+            {
+              try
+              {
+                run(loop, chunk);
+              }
+              catch(...)
+              {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error) error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+              }
+            }
+            // The last chunk wakes up the caller
+            if(done.fetch_add(1) + 1 == chunks) done.notify_all();
+          }
+        }
+      };
+
     // Variables ----
-      std::vector<std::thread>                        _workers;                                           // Working threads.
-      std::queue<std::function<void()>>               _tasks;                                             // Tasks queue.
-      std::mutex                                      _queueMutex;                                        // Lock for the queue.
-      std::condition_variable                         _condition;                                         // Condition for the lock.
-      bool                                            _stop                       = false;                // A stop sign for the pool.
+      SizingPolicy                                    _policy;                                            // How many workers the pool runs.
+      std::vector<std::thread>                        _workers;                                           // Working threads (a slot for every possible worker).
+      std::atomic<size_t>                             _active                     = 0;                    // Number of the running workers (they are in the first slots).
+      std::mutex                                      _resizeMutex;                                       // Lock of starting and retiring the workers.
+      std::atomic<int64_t>                            _backlogSince               = 0;                    // Time since the backlog is big (coarse clock, ns; 0 = no backlog).
+      std::vector<std::unique_ptr<WorkerQueue>>       _queues;                                            // Task deques of the workers.
+      std::atomic<size_t>                             _nextQueue                  = 0;                    // The deque of the next outside task (round-robin).
+      size_t                                          _reserved                   = 0;                    // Number of the workers running only high priority tasks (the first ones).
+      std::atomic<size_t>                             _pending                    = 0;                    // Number of the tasks in the deques.
+      std::array<std::atomic<size_t>, PRIORITY_COUNT>  _lanePending             = {};                   // Number of the tasks in the deques by priority.
+      std::atomic<size_t>                             _unfinished                 = 0;                    // Number of the tasks enqueued and not finished yet.
+      std::atomic<size_t>                             _draining                   = 0;                    // Number of the running drain() calls.
+      std::array<std::atomic<int64_t>, PRIORITY_COUNT>  _agingLimits              = { 0, 100000000, 1000000000 };  // Aging limits of the lanes in ns (0 = never).
+      std::atomic<bool>                               _waitTiming                 = false;                // Do we measure the times in the queue.
+      std::atomic<size_t>                             _sleepers                   = 0;                    // Number of the sleeping workers (nobody has woken them up yet).
+      std::atomic<bool>                               _stop                       = false;                // A stop sign for the pool.
+      static inline thread_local ThreadPool*          _tlsPool                    = nullptr;              // The pool of the current worker thread.
+      static inline thread_local size_t               _tlsIndex                   = 0;                    // Index of the current worker thread.
+      static inline thread_local Priority             _tlsPriority                = Priority::PRIORITY_NORMAL;  // Priority of the task running on the current worker thread.
+
+    // Functions ----
+      /**
+       * @brief Wakes up a sleeping worker (if there is one).
+       * @details The worker counts itself as a sleeper and sets its flag before it checks the tasks for the last time,
+       * and the tasks are counted before we look for the sleepers, so either the worker sees the task or we see the worker.
+       * 
+       * @param index The preferred worker.
+       * @param only Wake up only the preferred worker.
+       * @param high The task has high priority (the reserved workers are woken up only for them).
+       */
+      void _wakeUp(size_t index, bool only, bool high)
+      {
+        // Nobody sleeps
+        if(_sleepers.load() == 0) return;
+        // The first sleeping one, starting with the preferred one
+        for(size_t i = 0; i < (only ? 1 : _queues.size()); ++i)
+        {
+          size_t worker = (index + i) % _queues.size();
+          if(!high && worker < _reserved) continue;
+          WorkerQueue& queue = *_queues[worker];
+          uint32_t sleeping = 1;
+          if(queue.sleeping.load(std::memory_order_relaxed) != 1 || !queue.sleeping.compare_exchange_strong(sleeping, 0)) continue;
+          _sleepers.fetch_sub(1);
+          queue.wakeSignal.release();
+          return;
+        }
+      }
+      /**
+       * @brief Starts a new worker if the backlog has been big for a while.
+       * 
+       */
+      void _grow()
+      {
+        // The workers keep up: somebody sleeps or only a few tasks wait
+        size_t active = _active.load(std::memory_order_relaxed);
+        if(_sleepers.load(std::memory_order_relaxed) > 0 || _pending.load(std::memory_order_relaxed) < active * _policy.backlogPerWorker) return;
+        // The backlog has to last
+        int64_t now = _coarseNow();
+        int64_t since = _backlogSince.load(std::memory_order_relaxed);
+        if(since == 0)
+        {
+          _backlogSince.compare_exchange_strong(since, now);
+          return;
+        }
+        if(now - since < int64_t(_policy.growDelayMs) * 1000000) return;
+        // One start at a time (the others don't wait for it)
+        std::unique_lock<std::mutex> lock(_resizeMutex, std::try_to_lock);
+        if(!lock.owns_lock() || _stop.load()) return;
+        active = _active.load();
+        if(active >= _policy.maxWorkers) return;
+        // The thread of a retired worker has already left its loop
+        if(_workers[active].joinable()) _workers[active].join();
+        _workers[active] = std::thread(&ThreadPool::_workerLoop, this, active);
+        _active.store(active + 1);
+        // The next worker needs a lasting backlog again
+        _backlogSince.store(0, std::memory_order_relaxed);
+      }
+      /**
+       * @brief Retires an idle worker if it is over the minimum.
+       * 
+       * @param index Index of the worker.
+       * @return true The worker has to leave its loop.
+       * @return false It stays.
+       */
+      bool _retire(size_t index)
+      {
+        std::lock_guard<std::mutex> lock(_resizeMutex);
+        // Only the last worker retires (so the running ones stay in the first slots), and only without tasks
+        size_t active = _active.load();
+        if(index + 1 != active || active <= _policy.minWorkers || _hasWork(index) || _stop.load()) return false;
+        // Its deque can still get a task from an enqueue that was already running, but the others steal it
+        _active.store(active - 1);
+        return true;
+      }
+      /**
+       * @brief Gets the number of the indexes in a chunk.
+       * 
+       * @param count Number of the indexes.
+       * @param grain The wanted grain (0 = automatic).
+       * @return size_t The grain.
+       */
+      size_t _grainSize(size_t count, size_t grain) const
+      {
+        // About four chunks for every thread (with the caller), so the faster threads can take more of them
+        if(grain == 0) grain = count / ((size() + 1) * 4);
+        return std::max<size_t>(1, grain);
+      }
+      /**
+       * @brief Runs the chunks of a parallel loop with the helper tasks and the calling thread, and waits for the end.
+       * 
+       * @tparam F Type of the chunk function.
+       * @param chunks Number of the chunks.
+       * @param chunkFunction The chunk function (called with the index of the chunk).
+       */
+      template<typename F>
+      void _runChunks(size_t chunks, F& chunkFunction)
+      {
+        // A single chunk doesn't need the queues
+        if(chunks == 0) return;
+        if(chunks == 1)
+        {
+          chunkFunction(size_t(0));
+          return;
+        }
+        // The shared state
+        std::shared_ptr<LoopState> state = std::make_shared<LoopState>();
+        state->chunks = chunks;
+        state->run = [](void* loop, size_t chunk) { (*static_cast<F*>(loop))(chunk); };
+        state->loop = &chunkFunction;
+        // The helpers (the caller takes a chunk too), with the priority of the calling task
+        size_t helpers = std::min(size(), chunks - 1);
+        Priority priority = _tlsPool == this ? _tlsPriority : Priority::PRIORITY_NORMAL;
+        for(size_t i = 0; i < helpers; ++i) enqueue([state]() { state->work(); }, priority);
+        // Work with them, then wait for the chunks they are still running
+        state->work();
+        size_t done;
+        while((done = state->done.load()) < chunks) state->done.wait(done);
+        // Rethrow the first exception
+        if(state->error) std::rethrow_exception(state->error);
+      }
+      /**
+       * @brief Gets the current time of the steady clock.
+       * 
+       * @return int64_t The time in ns.
+       */
+      static int64_t _now()
+      {
+        return int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+      }
+      /**
+       * @brief Gets the current time of the coarse monotonic clock (the same clock as the steady clock, read cheaper, in ticks of a few ms).
+       * 
+       * @return int64_t The time in ns.
+       */
+      static int64_t _coarseNow()
+      {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+        return int64_t(time.tv_sec) * 1000000000 + int64_t(time.tv_nsec);
+      }
+      /**
+       * @brief Converts a deadline to the time of the steady clock.
+       * 
+       * @param deadline The deadline.
+       * @return int64_t The time in ns (max = no deadline).
+       */
+      static int64_t _toNanoseconds(std::chrono::steady_clock::time_point deadline)
+      {
+        if(deadline == std::chrono::steady_clock::time_point::max()) return std::numeric_limits<int64_t>::max();
+        return int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count());
+      }
+      /**
+       * @brief Checks if there are tasks for a worker in the deques.
+       * 
+       * @param index Index of the worker.
+       * @return true There are tasks.
+       * @return false No task for the worker.
+       */
+      bool _hasWork(size_t index) const
+      {
+        return index < _reserved ? _lanePending[0].load() > 0 : _pending.load() > 0;
+      }
+      /**
+       * @brief Takes a task out of a lane of a locked deque, and counts it.
+       * 
+       * @param index Index of the worker.
+       * @param queue The deque.
+       * @param lane The lane.
+       * @param front Take the oldest task (instead of the newest).
+       * @param promoted The task goes before a higher lane.
+       * @return Task The task.
+       */
+      Task _popTask(size_t index, WorkerQueue& queue, size_t lane, bool front, bool promoted)
+      {
+        QueuedTask entry = front ? queue.lanes[lane].pop_front() : queue.lanes[lane].pop_back();
+        queue.sizes[lane].store(queue.lanes[lane].size(), std::memory_order_relaxed);
+        _lanePending[lane].fetch_sub(1);
+        _pending.fetch_sub(1);
+        // Counted by the worker
+        LaneCounters& counters = _queues[index]->counters[lane];
+        counters.started.fetch_add(1, std::memory_order_relaxed);
+        if(promoted) counters.promoted.fetch_add(1, std::memory_order_relaxed);
+        // Bucket of the time in the queue (the position of its highest bit), if it is measured
+        if(entry.enqueuedAt == 0) return std::move(entry.task);
+        uint64_t wait = uint64_t(std::max<int64_t>(0, _now() - entry.enqueuedAt));
+        size_t bucket = wait > 1 ? std::min<size_t>(63 - size_t(__builtin_clzll(wait)), LaneStats::WAIT_BUCKETS - 1) : 0;
+        counters.queueWait[bucket].fetch_add(1, std::memory_order_relaxed);
+        return std::move(entry.task);
+      }
+      /**
+       * @brief Takes a task: from the own deque, or steals one from the front of another deque.
+       * @details An urgent task (it has waited for the aging limit, or its deadline has come) goes first: the own deque is checked
+       * for one, then every other deque. Otherwise the task of the highest lane that is not empty in any deque is taken: from the own deque
+       * if it has one in that lane (its newest task if the worker has enqueued it, otherwise its oldest one, so the tasks from outside
+       * keep their order), or the oldest one of another deque. The reserved workers look only at the high lanes.
+       * 
+       * @param index Index of the worker.
+       * @param task The task.
+       * @param lane The lane of the task.
+       * @return true We have a task.
+       * @return false Every deque is empty.
+       */
+      bool _takeTask(size_t index, Task& task, size_t& lane)
+      {
+        // Nothing anywhere
+        if(!_hasWork(index)) return false;
+        size_t lanes = index < _reserved ? 1 : PRIORITY_COUNT;
+        int64_t now = _coarseNow();
+        // The own deque: an urgent task, or the highest lane if no higher one waits in the other deques
+        WorkerQueue& own = *_queues[index];
+        size_t highest = PRIORITY_COUNT;
+        {
+          std::lock_guard<std::mutex> lock(own.mutex);
+          for(lane = 0; lane < lanes; ++lane)
+          {
+            if(own.lanes[lane].empty()) continue;
+            // An urgent task goes first
+            if(own.lanes[lane].front().urgentAt <= now)
+            {
+              task = _popTask(index, own, lane, true, highest < lane);
+              return true;
+            }
+            if(highest == PRIORITY_COUNT) highest = lane;
+          }
+          // The newest task of the highest lane (if it is our own), or its oldest one
+          if(highest < PRIORITY_COUNT && !_higherPending(highest))
+          {
+            lane = highest;
+            task = _popTask(index, own, lane, !own.lanes[lane].back().local, false);
+            return true;
+          }
+        }
+        // Stealing from the others
+        if(_stealTask(index, lanes, now, task, lane)) return true;
+        // The higher task has been taken meanwhile: the own deque again
+        if(highest < PRIORITY_COUNT)
+        {
+          std::lock_guard<std::mutex> lock(own.mutex);
+          for(lane = 0; lane < lanes; ++lane)
+          {
+            if(own.lanes[lane].empty()) continue;
+            task = _popTask(index, own, lane, !own.lanes[lane].back().local, false);
+            return true;
+          }
+        }
+        return false;
+      }
+      /**
+       * @brief Checks whether a higher lane than this one has tasks in any deque.
+       * 
+       * @param lane The lane.
+       * @return true A higher lane has tasks.
+       * @return false The higher lanes are empty.
+       */
+      bool _higherPending(size_t lane) const
+      {
+        for(size_t higher = 0; higher < lane; ++higher)
+          if(_lanePending[higher].load(std::memory_order_relaxed) > 0) return true;
+        return false;
+      }
+      /**
+       * @brief Steals a task from the front of another deque.
+       * @details The first urgent task found goes, otherwise the oldest task of the highest lane among the deques.
+       * 
+       * @param index Index of the worker.
+       * @param lanes Number of the lanes the worker looks at.
+       * @param now The current time (coarse clock, ns).
+       * @param task The task.
+       * @param lane The lane of the task.
+       * @return true We have a task.
+       * @return false The other deques are empty.
+       */
+      bool _stealTask(size_t index, size_t lanes, int64_t now, Task& task, size_t& lane)
+      {
+        // The deque with the highest lane
+        size_t bestQueue = index;
+        size_t bestLane = lanes;
+        for(size_t i = 1; i < _queues.size(); ++i)
+        {
+          // The empty deques are skipped without taking their locks
+          size_t victim = (index + i) % _queues.size();
+          WorkerQueue& queue = *_queues[victim];
+          bool empty = true;
+          for(lane = 0; lane < lanes && empty; ++lane) empty = queue.sizes[lane].load(std::memory_order_relaxed) == 0;
+          if(empty) continue;
+          std::lock_guard<std::mutex> lock(queue.mutex);
+          size_t highest = PRIORITY_COUNT;
+          for(lane = 0; lane < lanes; ++lane)
+          {
+            if(queue.lanes[lane].empty()) continue;
+            // An urgent task goes first
+            if(queue.lanes[lane].front().urgentAt <= now)
+            {
+              task = _popTask(index, queue, lane, true, highest < lane);
+              return true;
+            }
+            if(highest == PRIORITY_COUNT) highest = lane;
+          }
+          if(highest < bestLane)
+          {
+            bestLane = highest;
+            bestQueue = victim;
+          }
+        }
+        // The oldest task of the highest lane (or of a lower one, if it has been taken meanwhile)
+        if(bestLane == lanes) return false;
+        WorkerQueue& queue = *_queues[bestQueue];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for(lane = bestLane; lane < lanes; ++lane)
+        {
+          if(queue.lanes[lane].empty()) continue;
+          task = _popTask(index, queue, lane, true, false);
+          return true;
+        }
+        return false;
+      }
+      /**
+       * @brief The cycle of a worker.
+       * 
+       * @param index Index of the worker.
+       */
+      void _workerLoop(size_t index)
+      {
+        // Register the thread as a worker of this pool
+        _tlsPool = this;
+        _tlsIndex = index;
+        // Run a cycle
+        Task task;
+        size_t lane = 0;
+        while (true)
+        {
+          // Run the tasks while we find some
+          if(_takeTask(index, task, lane))
+          {
+            _tlsPriority = Priority(lane);
+            task();
+            task = nullptr;
+            // The last finished task wakes up the waiters of waitIdle()
+            if(_unfinished.fetch_sub(1) == 1) _unfinished.notify_all();
+            // A backlog left by a burst of enqueues grows the pool too
+            if(_active.load(std::memory_order_relaxed) < _policy.maxWorkers) _grow();
+            continue;
+          }
+          // If stop and no more tasks
+          if (_stop.load() && !_hasWork(index))
+            // Return
+            return;
+          // A sleeping worker means there is no backlog
+          if(_backlogSince.load(std::memory_order_relaxed) != 0) _backlogSince.store(0, std::memory_order_relaxed);
+          // Sleep until a task comes
+          WorkerQueue& queue = *_queues[index];
+          _sleepers.fetch_add(1);
+          queue.sleeping.store(1);
+          // A task (or the stop) could have come before we have set the flag: then we wake up ourselves
+          uint32_t sleeping = 1;
+          if((_hasWork(index) || _stop.load()) && queue.sleeping.compare_exchange_strong(sleeping, 0))
+          {
+            _sleepers.fetch_sub(1);
+            continue;
+          }
+          // The minimal workers wait until somebody wakes them up
+          if(index < _policy.minWorkers)
+          {
+            queue.wakeSignal.acquire();
+            continue;
+          }
+          // The others wait until the idle timeout
+          if(queue.wakeSignal.try_acquire_for(std::chrono::milliseconds(_policy.idleTimeoutMs))) continue;
+          sleeping = 1;
+          if(!queue.sleeping.compare_exchange_strong(sleeping, 0))
+          {
+            // Somebody has cleared the flag meanwhile, its signal is coming
+            queue.wakeSignal.acquire();
+            continue;
+          }
+          _sleepers.fetch_sub(1);
+          // Retire if we are over the minimum
+          if(_retire(index)) return;
+        }
+      }
 };
 
-#endif
\ No newline at end of file
+#endif
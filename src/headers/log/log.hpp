@@ -16,8 +16,38 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+#include <span>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <list>
+#include <source_location>
+#include <condition_variable>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
 
 #include "../general/datetime.hpp"
+#include "../general/ringbuffer.hpp"
+
+/**
+ * @brief The lowest MsgLevel compiled into the program (0 = debug, 1 = low, 2 = medium, 3 = high).
+ * @details Define it before including the log (e.g. -DDRLOG_MIN_LEVEL=2 for the release builds)
+ * and the posts under it become NullPosts: they don't format anything and the optimizer removes them.
+ * The DRLOG_* macros don't even evaluate the arguments of these posts.
+ * 
+ */
+#ifndef DRLOG_MIN_LEVEL
+  #define DRLOG_MIN_LEVEL 0
+#endif
 
 /**
  * @brief drLog namespace.
@@ -59,8 +89,51 @@ namespace drLog {
       LOG_ERROR = 31,
       LOG_DEBUG = 32
     };
+    /**
+     * @brief Behaviours of the asynchronous logging when its queue is full.
+     * 
+     */
+    enum class AsyncOverflow : unsigned int
+    {
+      ASYNC_BLOCK = 0,
+      ASYNC_DROP_NEWEST = 1,
+      ASYNC_OVERWRITE_OLDEST = 2,
+    };
+    /**
+     * @brief Types of the structured fields.
+     * 
+     */
+    enum class FieldType : unsigned int
+    {
+      FIELD_INT = 0,
+      FIELD_UINT = 1,
+      FIELD_DOUBLE = 2,
+      FIELD_BOOL = 3,
+      FIELD_STRING = 4,
+    };
+    /**
+     * @brief When the StdOutChannel colours the message types.
+     * 
+     */
+    enum class StdOutColor : unsigned int
+    {
+      COLOR_AUTO = 0,
+      COLOR_ALWAYS = 1,
+      COLOR_NEVER = 2,
+    };
   
   // Functions ----
+    /**
+     * @brief Checks if the posts of a message level are compiled into the program (see DRLOG_MIN_LEVEL).
+     * 
+     * @param level The message level.
+     * @return true The posts of the level are compiled.
+     * @return false The posts of the level are stripped.
+     */
+    constexpr bool levelCompiled(MsgLevel level)
+    {
+      return unsigned(level) >= unsigned(DRLOG_MIN_LEVEL);
+    }
     /**
      * @brief Gives back a string name from the MsgTypes enum.
      * 
@@ -115,25 +188,238 @@ namespace drLog {
       }
     }
   
+  // Structures ----
+    /**
+     * @brief A typed key-value pair attached to a log post.
+     * @details The key and the string value are views, they are valid as long as the record is.
+     * 
+     */
+    struct LogField
+    {
+      std::string_view          key;                                            // Name of the field.
+      FieldType                 type              = FieldType::FIELD_INT;       // Type of the value.
+      union
+      {
+        int64_t                 intValue          = 0;                          // FIELD_INT value.
+        uint64_t                uintValue;                                      // FIELD_UINT value.
+        double                  doubleValue;                                    // FIELD_DOUBLE value.
+        bool                    boolValue;                                      // FIELD_BOOL value.
+      };
+      std::string_view          stringValue;                                    // FIELD_STRING value.
+
+      /**
+       * @brief Appends the value as text (numbers in their shortest form, bools as true/false, strings as they are).
+       * 
+       * @param output The string we append to.
+       */
+      void appendValue(std::string& output) const
+      {
+        char number[32];
+        switch(type)
+        {
+          case FieldType::FIELD_INT:
+            output.append(number, std::to_chars(number, number + sizeof(number), intValue).ptr);
+            break;
+          case FieldType::FIELD_UINT:
+            output.append(number, std::to_chars(number, number + sizeof(number), uintValue).ptr);
+            break;
+          case FieldType::FIELD_DOUBLE:
+            output.append(number, std::to_chars(number, number + sizeof(number), doubleValue).ptr);
+            break;
+          case FieldType::FIELD_BOOL:
+            output.append(boolValue ? "true" : "false");
+            break;
+          case FieldType::FIELD_STRING:
+            output.append(stringValue);
+            break;
+        }
+      }
+    };
+    /**
+     * @brief An interned sender (get it from Log::sender()).
+     * @details The name is stored by the Log for its whole life, so the posts of the sender
+     * don't copy it, and the channels can cache things by the id.
+     * 
+     */
+    struct Sender
+    {
+      uint32_t                  id                = 0;                          // ID of the sender (0 = not interned).
+      std::string_view          name;                                           // Name of the sender.
+    };
+    /**
+     * @brief A log record as the channels get it.
+     * @details The strings are only views, they are valid during the write() call
+     * (except the className of an interned sender, which is valid as long as the Log).
+     * 
+     */
+    struct LogRecord
+    {
+      std::string_view          className;                                      // Name of the sender class.
+      std::string_view          message;                                        // The message.
+      MsgLevel                  level             = MsgLevel::MSG_L_LOW;        // Level of the message.
+      MsgType                   type              = MsgType::LOG_MSG;           // Type of the message.
+      std::chrono::system_clock::time_point   dateTime;                         // The datetime of the message.
+      std::span<const LogField> fields;                                         // The structured fields of the message.
+      uint32_t                  senderId          = 0;                          // ID of the interned sender (0 = not interned).
+      std::source_location      location;                                       // Where the message was posted.
+    };
+    /**
+     * @brief How the StdOutChannel writes its lines.
+     * @details By default every line goes out immediately with one write(2) call. With batchBytes the lines
+     * are collected and written together (when the batch is full, batchIntervalMs elapsed, an error comes, or at flush()).
+     * COLOR_AUTO colours the message types only if the standard output is a terminal.
+     * 
+     */
+    struct StdOutPolicy
+    {
+      StdOutColor               color             = StdOutColor::COLOR_AUTO;    // When we colour the message types.
+      size_t                    batchBytes        = 0;                          // Write the batch when it has at least this many bytes (0 = every line).
+      size_t                    batchIntervalMs   = 0;                          // Write the batch at least this often (0 = no timed writes).
+      bool                      writeOnError      = true;                       // Write the batch immediately when an error message comes.
+    };
+    /**
+     * @brief A limit on the posts of a sender with a message type.
+     * @details First only every sampleEvery-th post is kept, then a token bucket lets through ratePerSecond posts
+     * a second on average (and burst posts at once). The rest is thrown away before formatting, and the number of
+     * them is reported in a summary post (at most once per summaryIntervalMs, and at flush() and stopAsync()).
+     * 
+     */
+    struct RateLimit
+    {
+      double                    ratePerSecond     = 0;                          // Average number of the posts let through a second (0 = no rate limit).
+      size_t                    burst             = 1;                          // Number of the posts let through at once.
+      size_t                    sampleEvery       = 1;                          // Keep only every Nth post (1 = every post).
+      size_t                    summaryIntervalMs = 10000;                      // Report the suppressed posts at most this often.
+    };
+    /**
+     * @brief Snapshot of the counters of a channel.
+     * @details The counters only grow (from the creation of the channel), so the exporters can compute rates from them.
+     * The times are measured only if the timing of the metrics is on (see Log::metricsTiming()).
+     * 
+     */
+    struct ChannelMetrics
+    {
+      // Constants ----
+        static constexpr size_t LATENCY_BUCKETS = 32;                           // Number of the buckets of the latency histogram.
+
+      // Variables ----
+        int                                       id                = 0;        // ID of the channel in the Log.
+        std::array<uint64_t, 4>                   accepted          = {};       // Records given to write() by MsgLevel.
+        std::array<uint64_t, 4>                   filtered          = {};       // Records filtered out by the level of the channel by MsgLevel.
+        uint64_t                                  bytesWritten      = 0;        // Bytes written by the channel.
+        uint64_t                                  writeFailures     = 0;        // Failed writes (and file operations) of the channel.
+        uint64_t                                  lockWaitNs        = 0;        // Time spent waiting for the lock of the channel.
+        std::array<uint64_t, LATENCY_BUCKETS>     writeLatency      = {};       // Histogram of the write() times: bucket i counts [2^i, 2^(i+1)) ns.
+
+      // Functions ----
+        /**
+         * @brief Estimates a percentile of the write() times from the histogram.
+         * 
+         * @param rank The rank (e.g. 0.99).
+         * @return uint64_t The upper bound of the bucket of the percentile in nanoseconds (0 if nothing was measured).
+         */
+        uint64_t latencyPercentile(double rank) const
+        {
+          // Number of the measurements
+          uint64_t count = 0;
+          for(uint64_t bucket : writeLatency) count += bucket;
+          if(count == 0) return 0;
+          // Find the bucket of the rank
+          uint64_t target = uint64_t(rank * double(count));
+          uint64_t seen = 0;
+          for(size_t i = 0; i < LATENCY_BUCKETS; ++i)
+          {
+            seen += writeLatency[i];
+            if(seen > target) return uint64_t(2) << i;
+          }
+          return uint64_t(2) << (LATENCY_BUCKETS - 1);
+        }
+    };
+    /**
+     * @brief Snapshot of the counters of the logging.
+     * 
+     */
+    struct LogMetrics
+    {
+      std::array<uint64_t, 4>   accepted          = {};                         // Posts sent to the channels by MsgLevel.
+      std::array<uint64_t, 4>   filtered          = {};                         // Posts no channel accepted (or the rate limit suppressed) by MsgLevel.
+      uint64_t                  suppressed        = 0;                          // Posts suppressed by the rate limits.
+      uint64_t                  dropped           = 0;                          // Posts lost because of the full asynchronous queue.
+      std::vector<ChannelMetrics>   channels;                                   // Counters of the channels.
+    };
+
+  // Functions ----
+    /**
+     * @brief Appends the structured fields as text (" key=value key2=value2").
+     * @details String values with spaces, quotes or '=' in them (and the empty ones) are quoted, like in logfmt.
+     * 
+     * @param output The string we append to.
+     * @param fields The fields.
+     */
+    static void appendFieldsText(std::string& output, std::span<const LogField> fields)
+    {
+      for(const LogField& field : fields)
+      {
+        // The key
+        output.push_back(' ');
+        output.append(field.key);
+        output.push_back('=');
+        // Plain values
+        if(field.type != FieldType::FIELD_STRING || (!field.stringValue.empty() && field.stringValue.find_first_of(" =\"\\") == std::string_view::npos))
+        {
+          field.appendValue(output);
+          continue;
+        }
+        // Quoted strings
+        output.push_back('"');
+        for(char c : field.stringValue)
+        {
+          if(c == '"' || c == '\\') output.push_back('\\');
+          output.push_back(c);
+        }
+        output.push_back('"');
+      }
+    }
+    /**
+     * @brief Appends the source location as text (" (file:line)"), if the record has one.
+     * 
+     * @param output The string we append to.
+     * @param location The source location.
+     */
+    static void appendLocationText(std::string& output, const std::source_location& location)
+    {
+      if(location.line() == 0) return;
+      char number[16];
+      output.append(" (");
+      output.append(location.file_name());
+      output.push_back(':');
+      output.append(number, std::to_chars(number, number + sizeof(number), location.line()).ptr);
+      output.push_back(')');
+    }
+
   // Classes ----
+    class Log;
     /**
      * @brief A generic adapter class for handling various log outputs.
      * 
      */
     class LogChannel
     {
+      friend class Log;
+
       public:
         // Construction ----
           /**
            * @brief Constructs a new LogChannel object.
            * 
            * @param logLevel The level of the logging on the channel.
-           * @param DTFormat The datetime format of the logging on the channel.
+           * @param DTFormat The datetime format of the logging on the channel (see DTFormat() for the fractions of the second).
            */
           LogChannel(const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S")
             :
               p_LogLevel(logLevel),
-              p_DTFormat(DTFormat)
+              p_DTFormat(DTFormat),
+              p_TimeStamp(DTFormat)
           {}
           /**
            * @brief Destroys the Log Channel object.
@@ -145,25 +431,26 @@ namespace drLog {
           /**
            * @brief Writes the log.
            * 
-           * @param className Name of the sender class.
-           * @param message Message we want to write
-           * @param level Level of the message.
-           * @param type Type of the message.
-           * @param dateTime The datetime when we write it on the channel.
+           * @param record The record we want to write (its strings are valid only during the call).
            * @return true Write has successed.
            * @return false Write has failed.
            */
-          virtual bool write(std::string className, std::string message, MsgLevel level, MsgType type, const std::time_t& dateTime) = 0;
+          virtual bool write(const LogRecord& record) = 0;
+          /**
+           * @brief Flushes the buffered logs of the channel (if it has any).
+           * 
+           */
+          virtual void flush() {}
 
         // Getter ----
           /**
            * @brief Gets the level of the logging of the Channel.
            * 
-           * @return const LogLevels& The level of the logging of the Channel.
+           * @return LogLevel The level of the logging of the Channel.
            */
-          const LogLevel& logLevel() const
+          LogLevel logLevel() const
           {
-            return p_LogLevel;
+            return p_LogLevel.load(std::memory_order_relaxed);
           }
           /**
            * @brief Gets the datetime format of the Channel.
@@ -174,31 +461,144 @@ namespace drLog {
           {
             return p_DTFormat;
           }
+          /**
+           * @brief Gets if the channel writes the source location (file:line) of the messages.
+           * 
+           * @return true The source location is written.
+           * @return false The source location is not written.
+           */
+          bool sourceLocation() const
+          {
+            return p_SourceLocation.load(std::memory_order_relaxed);
+          }
+          /**
+           * @brief Gets the counters of the channel.
+           * 
+           * @return ChannelMetrics Snapshot of the counters (the id is filled by Log::metrics()).
+           */
+          ChannelMetrics metrics() const
+          {
+            ChannelMetrics metrics;
+            for(size_t i = 0; i < 4; ++i)
+            {
+              metrics.accepted[i] = _counters.accepted[i].load(std::memory_order_relaxed);
+              metrics.filtered[i] = _counters.filtered[i].load(std::memory_order_relaxed);
+            }
+            metrics.bytesWritten = _counters.bytesWritten.load(std::memory_order_relaxed);
+            metrics.writeFailures = _counters.writeFailures.load(std::memory_order_relaxed);
+            metrics.lockWaitNs = _counters.lockWaitNs.load(std::memory_order_relaxed);
+            for(size_t i = 0; i < ChannelMetrics::LATENCY_BUCKETS; ++i) metrics.writeLatency[i] = _counters.writeLatency[i].load(std::memory_order_relaxed);
+            return metrics;
+          }
 
       // Setters ----
           /**
-           * @brief Sets the level of the logging.
+           * @brief Sets the level of the logging (and tells it to the Log, if the channel is added to it).
            * 
            * @param newLevel The new level of the logging.
            */
-          void logLevel(LogLevel newLevel)
-          {
-            p_LogLevel = newLevel;
-          }
+          void logLevel(LogLevel newLevel);
           /**
            * @brief Sets the datetime format of the logging.
+           * @details Besides the strftime specifiers it can contain '%L' (milliseconds), '%f' (microseconds) and '%N' (nanoseconds).
            * 
            * @param newDTFormat The new datetime format of the logging.
            */
           void DTFormat(const std::string& newDTFormat)
           {
+            // The channel could be writing right now
+            std::lock_guard<std::mutex> lock(p_ChannelMutex);
             p_DTFormat = newDTFormat;
+            p_TimeStamp.dateTimeFormat(newDTFormat);
+          }
+          /**
+           * @brief Sets if the channel writes the source location (file:line) of the messages.
+           * 
+           * @param enabled Should the source location be written.
+           */
+          void sourceLocation(bool enabled)
+          {
+            p_SourceLocation.store(enabled, std::memory_order_relaxed);
           }
       
       protected:
         // Variables ----
-          LogLevel            p_LogLevel          = LogLevel::LOG_LEVEL_NORMAL;         // Level of the logging on the channel.
-          std::string         p_DTFormat          = "%Y-%m-%d %H:%M:%S";                // The datetime format of the Channel.
+          std::atomic<LogLevel>                   p_LogLevel        = LogLevel::LOG_LEVEL_NORMAL;       // Level of the logging on the channel.
+          std::string                             p_DTFormat        = "%Y-%m-%d %H:%M:%S";              // The datetime format of the Channel.
+          Utils::DateTime::TimeStampFormatter     p_TimeStamp;                                          // Cached formatter of the timestamps.
+          std::mutex                              p_ChannelMutex;                                       // Serializes the writes of the channel (held during write() and flush()).
+          std::atomic<bool>                       p_SourceLocation  = false;                            // Should the channel write the source location of the messages.
+
+        // Functions ----
+          /**
+           * @brief Counts the bytes the channel has written (for the metrics).
+           * 
+           * @param bytes Number of the bytes.
+           */
+          void p_addWritten(size_t bytes)
+          {
+            _counters.bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+          }
+          /**
+           * @brief Counts a failed write or file operation of the channel (for the metrics).
+           * 
+           */
+          void p_addFailure()
+          {
+            _counters.writeFailures.fetch_add(1, std::memory_order_relaxed);
+          }
+          /**
+           * @brief Writes a post while holding the lock of the channel, and counts it (for the metrics).
+           * @details The posts under the level of the channel are counted and skipped without locking.
+           * 
+           * @tparam Writer Type of the function writing the post.
+           * @param level Level of the post.
+           * @param writer The function writing the post (it returns false if the write has failed).
+           * @return true Write has successed.
+           * @return false Write has failed.
+           */
+          template<typename Writer>
+          bool p_countedWrite(MsgLevel level, Writer&& writer);
+
+      private:
+        // Structures ----
+          /**
+           * @brief The counters of the channel.
+           * 
+           */
+          struct Counters
+          {
+            std::array<std::atomic<uint64_t>, 4>    accepted        = {};                               // Records given to write() by MsgLevel.
+            std::array<std::atomic<uint64_t>, 4>    filtered        = {};                               // Records filtered out by MsgLevel.
+            std::atomic<uint64_t>                   bytesWritten    = 0;                                // Bytes written.
+            std::atomic<uint64_t>                   writeFailures   = 0;                                // Failed writes.
+            std::atomic<uint64_t>                   lockWaitNs      = 0;                                // Time spent waiting for the lock.
+            std::array<std::atomic<uint64_t>, ChannelMetrics::LATENCY_BUCKETS>  writeLatency = {};      // Histogram of the write() times.
+          };
+
+        // Variables ----
+          std::atomic<Log*>                       _owner            = nullptr;                          // The Log the channel is added to.
+          Counters                                _counters;                                            // The counters of the metrics.
+
+        // Functions ----
+          /**
+           * @brief Writes a record while holding the lock of the channel (and counts it).
+           * @details The records under the level of the channel are counted and skipped without locking.
+           * 
+           * @param record The record we want to write.
+           * @return true Write has successed.
+           * @return false Write has failed.
+           */
+          bool _post(const LogRecord& record);
+          /**
+           * @brief Flushes the channel while holding the lock of the channel.
+           * 
+           */
+          void _flush()
+          {
+            std::lock_guard<std::mutex> lock(p_ChannelMutex);
+            flush();
+          }
     };
     /**
      * @brief The logging module.
@@ -206,15 +606,23 @@ namespace drLog {
      */
     class Log
     {
+      friend class LogChannel;
+
       public:
         // Classes ----
           /**
            * @brief An object to collect the data about what we wanted to post.
+           * @details The message is collected into a reusable buffer of the posting thread, and the
+           * built-in types are formatted with std::to_chars, so after the first few posts a message
+           * doesn't allocate at all. Other types (and stream manipulators) switch the post to a
+           * reusable std::ostringstream of the thread, which formats the rest of the message.
+           * If no channel would accept the post, it is disabled: it doesn't take a buffer,
+           * the '<<' operators don't format anything and nothing is sent to the channels.
+           * If a callable (e.g. a lambda) is put into the post, it is called only when the post is enabled,
+           * so costly arguments can be computed lazily: drlog.debug("x") << [&]{ return expensive(); };
            * 
            */
           class LogPost
-            :
-              public std::stringstream
           {
             public:
               // Construction ----
@@ -225,24 +633,192 @@ namespace drLog {
                  * @param className Name of the class that sends the message.
                  * @param level Level of the message.
                  * @param type Type of the message.
+                 * @param enabled Should the post be formatted and sent to the channels.
+                 * @param location Where the message was posted.
                  */
-                LogPost(Log& logger, const std::string& className, MsgLevel level=MsgLevel::MSG_L_LOW, MsgType type=MsgType::LOG_MSG)
+                LogPost(Log& logger, std::string_view className, MsgLevel level=MsgLevel::MSG_L_LOW, MsgType type=MsgType::LOG_MSG, bool enabled=true, std::source_location location=std::source_location())
                   :
+                    _level(level),
+                    _type(type),
                     _parentLogger(logger),
-                    _className(className),
+                    _enabled(enabled),
+                    _location(location)
+                {
+                  // Disabled posts don't need a buffer
+                  if(!_enabled) return;
+                  // Take a buffer of the thread and put the classname at its beginning
+                  _buffer = _threadBuffers().takeString();
+                  _buffer.append(className);
+                  _classNameSize = className.size();
+                }
+                /**
+                 * @brief Constructs a new LogPost object of an interned sender (its name is not copied).
+                 * 
+                 * @param logger The logger parent.
+                 * @param sender The interned sender.
+                 * @param level Level of the message.
+                 * @param type Type of the message.
+                 * @param enabled Should the post be formatted and sent to the channels.
+                 * @param location Where the message was posted.
+                 */
+                LogPost(Log& logger, const Sender& sender, MsgLevel level=MsgLevel::MSG_L_LOW, MsgType type=MsgType::LOG_MSG, bool enabled=true, std::source_location location=std::source_location())
+                  :
                     _level(level),
-                    _type(type)
-                {}
+                    _type(type),
+                    _parentLogger(logger),
+                    _enabled(enabled),
+                    _sender(sender),
+                    _location(location)
+                {
+                  // Disabled posts don't need a buffer
+                  if(_enabled) _buffer = _threadBuffers().takeString();
+                }
+                // Not copyable
+                LogPost(const LogPost&) = delete;
+                LogPost& operator=(const LogPost&) = delete;
                 /**
                  * @brief Destroys the LogPost object.
                  * 
                  */
                 ~LogPost()
                 {
-                  _parentLogger._sendToChannels(_className, (*this).str(), _level, _type);
+                  // Disabled posts don't go anywhere
+                  if(!_enabled) return;
+                  // Collect the end of the message from the stream (if we used it)
+                  if(_stream)
+                  {
+                    _buffer.append(_stream->view());
+                    _threadBuffers().giveStream(std::move(_stream));
+                  }
+                  // Send it
+                  LogRecord record { className(), message(), _level, _type, {}, fields(), _sender.id, _location };
+                  _parentLogger._sendToChannels(record);
+                  // Give back the buffers to the thread
+                  _threadBuffers().giveString(std::move(_buffer));
+                  if(_fieldCount > 0) _threadBuffers().giveString(std::move(_fieldText));
                 };
-              
+
+              // Functions ----
+                /**
+                 * @brief Attaches a typed field to the post.
+                 * @details The value is stored without formatting: integers, floating points, bools and strings
+                 * (the key and the string values are copied, so temporaries are fine). A post holds at most
+                 * MAX_FIELDS fields, the rest is ignored.
+                 * 
+                 * @tparam T Type of the value. If it is callable without arguments, its result is stored.
+                 * @param key Name of the field.
+                 * @param value The value.
+                 * @return LogPost& The post itself.
+                 */
+                template<typename T>
+                LogPost& field(std::string_view key, T&& value)
+                {
+                  // Disabled posts don't store anything, and we have limited space
+                  if(!_enabled || _fieldCount >= MAX_FIELDS) return *this;
+                  // Lazy values are evaluated only now
+                  if constexpr (std::is_invocable_v<T&>) return field(key, value());
+                  else
+                  {
+                    using Type = std::remove_cvref_t<T>;
+                    // The first field takes a buffer for the strings
+                    if(_fieldCount == 0) _fieldText = _threadBuffers().takeString();
+                    // Store the key
+                    LogField& stored = *std::construct_at(&_fields[_fieldCount]);
+                    stored.key = _keepText(key, _fieldCount);
+                    // Store the value by its type
+                    if constexpr (std::is_same_v<Type, bool>)
+                    {
+                      stored.type = FieldType::FIELD_BOOL;
+                      stored.boolValue = value;
+                    }
+                    else if constexpr (std::is_same_v<Type, char>)
+                    {
+                      stored.type = FieldType::FIELD_STRING;
+                      stored.stringValue = _keepText(std::string_view(&value, 1), _fieldCount);
+                    }
+                    else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>)
+                    {
+                      stored.type = FieldType::FIELD_INT;
+                      stored.intValue = int64_t(value);
+                    }
+                    else if constexpr (std::is_integral_v<Type>)
+                    {
+                      stored.type = FieldType::FIELD_UINT;
+                      stored.uintValue = uint64_t(value);
+                    }
+                    else if constexpr (std::is_floating_point_v<Type>)
+                    {
+                      stored.type = FieldType::FIELD_DOUBLE;
+                      stored.doubleValue = double(value);
+                    }
+                    else if constexpr (std::is_pointer_v<Type> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Type>>, char>)
+                    {
+                      stored.type = FieldType::FIELD_STRING;
+                      stored.stringValue = _keepText(value ? std::string_view(value) : std::string_view(), _fieldCount);
+                    }
+                    else
+                    {
+                      static_assert(std::is_convertible_v<const Type&, std::string_view>, "Fields can be integers, floating points, bools or strings.");
+                      stored.type = FieldType::FIELD_STRING;
+                      stored.stringValue = _keepText(std::string_view(value), _fieldCount);
+                    }
+                    ++_fieldCount;
+                    return *this;
+                  }
+                }
+
+              // Operators ----
+                /**
+                 * @brief Puts a value into the post.
+                 * 
+                 * @tparam T Type of the value. If it is callable without arguments, its result goes into the post.
+                 * @param value The value we want to write.
+                 * @return LogPost& The post itself.
+                 */
+                template<typename T>
+                LogPost& operator<<(T&& value)
+                {
+                  // Disabled posts don't format anything
+                  if(!_enabled) return *this;
+                  // Lazy arguments are evaluated only now
+                  if constexpr (std::is_invocable_v<T&>) _append(value());
+                  else _append(std::forward<T>(value));
+                  return *this;
+                }
+                /**
+                 * @brief Puts a stream manipulator (e.g. std::endl) into the post.
+                 * 
+                 * @param manipulator The manipulator.
+                 * @return LogPost& The post itself.
+                 */
+                LogPost& operator<<(std::ostream& (*manipulator)(std::ostream&))
+                {
+                  if(_enabled) manipulator(_useStream());
+                  return *this;
+                }
+                /**
+                 * @brief Puts a stream format manipulator (e.g. std::hex) into the post.
+                 * 
+                 * @param manipulator The manipulator.
+                 * @return LogPost& The post itself.
+                 */
+                LogPost& operator<<(std::ios_base& (*manipulator)(std::ios_base&))
+                {
+                  if(_enabled) manipulator(_useStream());
+                  return *this;
+                }
+
               // Getters ----
+                /**
+                 * @brief Gets if the post will be sent to the channels.
+                 * 
+                 * @return true The post is enabled.
+                 * @return false No channel would accept the post.
+                 */
+                bool enabled() const
+                {
+                  return _enabled;
+                }
                 /**
                  * @brief Gets the message level.
                  * 
@@ -264,55 +840,338 @@ namespace drLog {
                 /**
                  * @brief Gets the sender's classname.
                  * 
-                 * @return const MsgLevels& The sender's classname.
+                 * @return std::string_view The sender's classname.
+                 */
+                std::string_view className() const
+                {
+                  if(_sender.id != 0) return _sender.name;
+                  return std::string_view(_buffer).substr(0, _classNameSize);
+                }
+                /**
+                 * @brief Gets the message collected so far (without the part still in the stream).
+                 * 
+                 * @return std::string_view The message.
+                 */
+                std::string_view message() const
+                {
+                  return std::string_view(_buffer).substr(_classNameSize);
+                }
+                /**
+                 * @brief Gets the structured fields of the post.
+                 * 
+                 * @return std::span<const LogField> The fields.
                  */
-                const std::string& className() const
+                std::span<const LogField> fields() const
                 {
-                  return _className;
+                  return std::span<const LogField>(_fields.data(), _fieldCount);
                 }
-              
+
+              // Constants ----
+                static constexpr size_t                 MAX_FIELDS      = 8;      // Maximum number of the fields of a post.
+
             private:
+              // Structures ----
+                /**
+                 * @brief Reusable buffers of a thread.
+                 * 
+                 */
+                struct ThreadBuffers
+                {
+                  // Variables ----
+                    std::vector<std::string>                            strings;          // Free message buffers.
+                    std::vector<std::unique_ptr<std::ostringstream>>    streams;          // Free formatting streams.
+
+                  // Functions ----
+                    /**
+                     * @brief Takes a message buffer (or creates one if there is no free buffer).
+                     * 
+                     * @return std::string An empty buffer.
+                     */
+                    std::string takeString()
+                    {
+                      // Create a new one
+                      if(strings.empty())
+                      {
+                        std::string buffer;
+                        buffer.reserve(256);
+                        return buffer;
+                      }
+                      // Give back the last one
+                      std::string buffer = std::move(strings.back());
+                      strings.pop_back();
+                      return buffer;
+                    }
+                    /**
+                     * @brief Gives back a message buffer.
+                     * 
+                     * @param buffer The buffer.
+                     */
+                    void giveString(std::string&& buffer)
+                    {
+                      // We don't keep too many or too big buffers
+                      if(strings.size() >= 8 || buffer.capacity() > 64 * 1024) return;
+                      // Clear and keep it
+                      buffer.clear();
+                      strings.push_back(std::move(buffer));
+                    }
+                    /**
+                     * @brief Takes a formatting stream with the default formatting.
+                     * 
+                     * @return std::unique_ptr<std::ostringstream> An empty stream.
+                     */
+                    std::unique_ptr<std::ostringstream> takeStream()
+                    {
+                      // Create a new one
+                      if(streams.empty()) return std::make_unique<std::ostringstream>();
+                      // Give back the last one
+                      std::unique_ptr<std::ostringstream> stream = std::move(streams.back());
+                      streams.pop_back();
+                      return stream;
+                    }
+                    /**
+                     * @brief Gives back a formatting stream.
+                     * 
+                     * @param stream The stream.
+                     */
+                    void giveStream(std::unique_ptr<std::ostringstream>&& stream)
+                    {
+                      // We don't keep too many streams
+                      if(streams.size() >= 8) return;
+                      // Reset the content (keeping its capacity) and the formatting
+                      stream->str("");
+                      stream->clear();
+                      stream->flags(std::ios_base::dec | std::ios_base::skipws);
+                      stream->precision(6);
+                      stream->width(0);
+                      stream->fill(' ');
+                      streams.push_back(std::move(stream));
+                    }
+                };
+
               // Variables ----
-                MsgLevel                _level;           // Level of the message.
-                MsgType                 _type;            // Type of the message.
-                const std::string       _className;       // ClassName of the message.
-                Log&                    _parentLogger;    // Parent of the logpost.
+                MsgLevel                                _level;                   // Level of the message.
+                MsgType                                 _type;                    // Type of the message.
+                Log&                                    _parentLogger;            // Parent of the logpost.
+                bool                                    _enabled;                 // Should the post be sent to the channels.
+                std::string                             _buffer;                  // ClassName and the message of the post.
+                size_t                                  _classNameSize  = 0;      // Length of the classname at the beginning of the buffer.
+                Sender                                  _sender;                  // The interned sender (if the post has one).
+                std::source_location                    _location;                // Where the message was posted.
+                std::unique_ptr<std::ostringstream>     _stream;                  // Stream for the types we can't format directly.
+                union
+                {
+                  std::array<LogField, MAX_FIELDS>      _fields;                  // The structured fields (constructed one by one, so the posts without fields don't pay for them).
+                };
+                size_t                                  _fieldCount     = 0;      // Number of the structured fields.
+                std::string                             _fieldText;               // Keys and string values of the fields.
 
-          };
+              // Functions ----
+                /**
+                 * @brief Gets the reusable buffers of the current thread.
+                 * 
+                 * @return ThreadBuffers& The buffers of the thread.
+                 */
+                static ThreadBuffers& _threadBuffers()
+                {
+                  thread_local ThreadBuffers buffers;
+                  return buffers;
+                }
+                /**
+                 * @brief Copies a key or string value of a field into the field buffer.
+                 * @details If the buffer has to grow, the views of the earlier fields are moved to the new buffer.
+                 * 
+                 * @param text The text.
+                 * @param fieldCount Number of the fields already stored (they have to be moved).
+                 * @return std::string_view The view of the copy.
+                 */
+                std::string_view _keepText(std::string_view text, size_t fieldCount)
+                {
+                  // Where the text goes
+                  size_t offset = _fieldText.size();
+                  // Growing the buffer ourself, so we know where the views have to go
+                  if(offset + text.size() > _fieldText.capacity())
+                  {
+                    std::string grown;
+                    grown.reserve(std::max(2 * _fieldText.capacity(), offset + text.size()));
+                    grown.append(_fieldText);
+                    // Move the views of the fields (including the one in progress)
+                    auto move = [&](std::string_view view) { return view.empty() ? view : std::string_view(grown.data() + (view.data() - _fieldText.data()), view.size()); };
+                    for(size_t i = 0; i <= fieldCount && i < MAX_FIELDS; ++i)
+                    {
+                      _fields[i].key = move(_fields[i].key);
+                      if(_fields[i].type == FieldType::FIELD_STRING) _fields[i].stringValue = move(_fields[i].stringValue);
+                    }
+                    _fieldText.swap(grown);
+                  }
+                  // Copy it
+                  _fieldText.append(text);
+                  return std::string_view(_fieldText.data() + offset, text.size());
+                }
+                /**
+                 * @brief Switches the post to the formatting stream.
+                 * 
+                 * @return std::ostream& The stream.
+                 */
+                std::ostream& _useStream()
+                {
+                  if(!_stream) _stream = _threadBuffers().takeStream();
+                  return *_stream;
+                }
+                /**
+                 * @brief Formats a value into the buffer.
+                 * 
+                 * @tparam T Type of the value.
+                 * @param value The value.
+                 */
+                template<typename T>
+                void _append(T&& value)
+                {
+                  using Type = std::remove_cvref_t<T>;
+                  // After a manipulator or an unknown type the stream formats everything (so the formatting flags work)
+                  if(_stream) *_stream << std::forward<T>(value);
+                  // Bools as numbers (like the streams do by default)
+                  else if constexpr (std::is_same_v<Type, bool>) _buffer.push_back(value ? '1' : '0');
+                  // Characters
+                  else if constexpr (std::is_same_v<Type, char> || std::is_same_v<Type, signed char> || std::is_same_v<Type, unsigned char>) _buffer.push_back(char(value));
+                  // Integers
+                  else if constexpr (std::is_integral_v<Type>)
+                  {
+                    char number[24];
+                    _buffer.append(number, std::to_chars(number, number + sizeof(number), value).ptr);
+                  }
+                  // Floating points (general format with precision 6, like the streams do by default)
+                  else if constexpr (std::is_floating_point_v<Type>)
+                  {
+                    char number[64];
+                    _buffer.append(number, std::to_chars(number, number + sizeof(number), value, std::chars_format::general, 6).ptr);
+                  }
+                  // C strings (a null pointer writes nothing)
+                  else if constexpr (std::is_pointer_v<Type> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Type>>, char>)
+                  {
+                    if(value) _buffer.append(value);
+                  }
+                  // Strings and string views
+                  else if constexpr (std::is_convertible_v<const Type&, std::string_view>) _buffer.append(std::string_view(value));
+                  // Everything else goes through the stream
+                  else _useStream() << std::forward<T>(value);
+                }
 
-        // Construction ----
-          /**
-           * @brief Create an instance of the Log class.
-           * 
-           * @return Log& The instance of the log.
-           */
-          static Log& getInstance()
-          {
-            // Create instance
-            static Log instance;
-            // Return with the instance
-            return instance;
-          }
-        
-        // Functions ----
+          };
           /**
-           * @brief Adds a channel to the channelList.
+           * @brief A post of a message level stripped at compile time (see DRLOG_MIN_LEVEL).
+           * @details It has the interface of the LogPost, but every function is empty,
+           * so the optimizer removes the whole post (and the lazy arguments are never called).
            * 
-           * @param id ID of the channel.
-           * @param channel The channel we want to add to the list.
            */
-          void addChannel(const int& id, std::shared_ptr<LogChannel> channel)
+          class NullPost
           {
-            // Check if we have channel with the same id
-            if(_logChannels.contains(id))
-            {
-              // We have a channel with this id
-              std::cerr << "!!!--> We already have a channel with ID '" << id << "' <--!!!" << std::endl;
-              // Return
-              return;
+            public:
+              // Operators ----
+                /**
+                 * @brief Ignores a value.
+                 * 
+                 * @return NullPost& The post itself.
+                 */
+                template<typename T>
+                NullPost& operator<<(T&&)
+                {
+                  return *this;
+                }
+                /**
+                 * @brief Ignores a stream manipulator.
+                 * 
+                 * @return NullPost& The post itself.
+                 */
+                NullPost& operator<<(std::ostream& (*)(std::ostream&))
+                {
+                  return *this;
+                }
+                /**
+                 * @brief Ignores a stream format manipulator.
+                 * 
+                 * @return NullPost& The post itself.
+                 */
+                NullPost& operator<<(std::ios_base& (*)(std::ios_base&))
+                {
+                  return *this;
+                }
+
+              // Functions ----
+                /**
+                 * @brief Ignores a structured field.
+                 * 
+                 * @return NullPost& The post itself.
+                 */
+                template<typename T>
+                NullPost& field(std::string_view, T&&)
+                {
+                  return *this;
+                }
+
+              // Getters ----
+                /**
+                 * @brief Gets if the post will be sent to the channels.
+                 * 
+                 * @return false Never.
+                 */
+                constexpr bool enabled() const
+                {
+                  return false;
+                }
+          };
+
+        // Types ----
+          /**
+           * @brief The post type of a message level: LogPost, or NullPost if the level is stripped at compile time.
+           * 
+           */
+          template<MsgLevel Level>
+          using Post = std::conditional_t<levelCompiled(Level), LogPost, NullPost>;
+
+        // Construction ----
+          /**
+           * @brief Create an instance of the Log class.
+           * 
+           * @return Log& The instance of the log.
+           */
+          static Log& getInstance()
+          {
+            // Create instance
+            static Log instance;
+            // Return with the instance
+            return instance;
+          }
+        
+        // Functions ----
+          /**
+           * @brief Adds a channel to the channelList.
+           * 
+           * @param id ID of the channel.
+           * @param channel The channel we want to add to the list.
+           */
+          void addChannel(const int& id, std::shared_ptr<LogChannel> channel)
+          {
+            // Only one modification at a time
+            std::lock_guard<std::mutex> lock(_registryMutex);
+            // Get the current list
+            std::shared_ptr<const ChannelMap> channels = _logChannels.load();
+            // Check if we have channel with the same id
+            if(channels->contains(id))
+            {
+              // We have a channel with this id
+              std::cerr << "!!!--> We already have a channel with ID '" << id << "' <--!!!" << std::endl;
+              // Return
+              return;
             }
-            // Inserting channel
-            _logChannels.insert( { id, channel } );
+            // Inserting channel into a copy of the list
+            std::shared_ptr<ChannelMap> newChannels = std::make_shared<ChannelMap>(*channels);
+            newChannels->insert( { id, channel } );
+            // The channel tells us if its level changes
+            channel->_owner.store(this);
+            // Publish the new list (the writers still using the old one finish with that)
+            _logChannels.store(newChannels);
+            // Refresh the lowest accepted level
+            _updateMinLevel();
           }
           /**
            * @brief Removes a channel from the channelList.
@@ -321,16 +1180,271 @@ namespace drLog {
            */
           void removeChannel(const int& id)
           {
+            // Only one modification at a time
+            std::lock_guard<std::mutex> lock(_registryMutex);
+            // Get the current list
+            std::shared_ptr<const ChannelMap> channels = _logChannels.load();
             // Check if we have channel with this id
-            if(!_logChannels.contains(id))
+            if(!channels->contains(id))
             {
                 // We have a channel with this id
                 std::cerr << "!!!--> We don't have a channel with ID '" << id << "' <--!!!" << std::endl;
                 // Return
                 return;
             }
-            // Erasing this channel
-            _logChannels.erase(id);
+            // The channel is not ours anymore
+            channels->at(id)->_owner.store(nullptr);
+            // Erasing this channel from a copy of the list
+            std::shared_ptr<ChannelMap> newChannels = std::make_shared<ChannelMap>(*channels);
+            newChannels->erase(id);
+            // Publish the new list (the writers still using the old one finish with that)
+            _logChannels.store(newChannels);
+            // Refresh the lowest accepted level
+            _updateMinLevel();
+          }
+          /**
+           * @brief Switches the logging to asynchronous mode.
+           * @details The posts are put into a bounded lock-free queue and a background thread writes them
+           * into the channels, so the caller doesn't wait for the channels. Calling it again while
+           * the asynchronous mode is running has no effect.
+           * 
+           * @param queueSize Size of the queue (rounded up to a power of two).
+           * @param overflow What should happen when the queue is full.
+           */
+          void startAsync(size_t queueSize = 8192, AsyncOverflow overflow = AsyncOverflow::ASYNC_BLOCK)
+          {
+            // Check if we are already running
+            if(_asyncRunning.load()) return;
+            // Create the queue
+            _asyncQueue = std::make_unique<Utils::RingBuffer<AsyncPost>>(queueSize);
+            _asyncOverflow = overflow;
+            _asyncPushed.store(0);
+            _asyncDone.store(0);
+            // Start the writer thread
+            _asyncRunning.store(true);
+            _asyncWriter = std::thread(&Log::_asyncWriterLoop, this);
+          }
+          /**
+           * @brief Switches the logging back to synchronous mode.
+           * @details Every queued post (and the summary of the suppressed posts) is written before it returns.
+           * The switch is not synchronized with the posting threads, so stop the logging threads before calling it.
+           * 
+           */
+          void stopAsync()
+          {
+            // Check if we are running at all
+            if(!_asyncRunning.load()) return;
+            // Report the suppressed posts while the writer still runs
+            if(_rateLimited.load(std::memory_order_relaxed)) _reportAllSuppressed();
+            if(!_asyncRunning.exchange(false)) return;
+            // Wake up the writer, so it can drain the queue and exit
+            _asyncPushed.fetch_add(1);
+            _asyncPushed.notify_all();
+            // Wait for the writer
+            if(_asyncWriter.joinable()) _asyncWriter.join();
+            // Write the leftovers (posts which came in while we were stopping)
+            while(_asyncQueue->tryPop([this](AsyncPost& post) { _writeToChannels(post.record()); }))
+            {
+              _asyncDone.fetch_add(1);
+            }
+            // Wake up the producers who are waiting for space, they will write synchronously
+            _asyncDone.fetch_add(1);
+            _asyncDone.notify_all();
+            // Flush the channels
+            _flushChannels();
+          }
+          /**
+           * @brief Waits until every post sent before the call is written, then flushes the channels.
+           * 
+           */
+          void flush()
+          {
+            // Report the suppressed posts, so they don't wait for the next post of their sender
+            if(_rateLimited.load(std::memory_order_relaxed)) _reportAllSuppressed();
+            // In asynchronous mode we wait for the writer thread
+            if(_asyncRunning.load())
+            {
+              // Everything we have to wait for
+              size_t target = _asyncPushed.load();
+              // Waiting for the writer
+              size_t done = _asyncDone.load();
+              while(done < target && _asyncRunning.load())
+              {
+                _asyncDone.wait(done);
+                done = _asyncDone.load();
+              }
+            }
+            // Flush the channels
+            _flushChannels();
+          }
+
+        // Getters ----
+          /**
+           * @brief Gets if any channel would accept a message on the given level.
+           * 
+           * @param level Level of the message.
+           * @return true At least one channel accepts it.
+           * @return false Every channel would throw it away.
+           */
+          bool isEnabled(MsgLevel level) const
+          {
+            return (unsigned int)(level) >= _minLevel.load(std::memory_order_relaxed);
+          }
+          /**
+           * @brief Gets if the logging is in asynchronous mode.
+           * 
+           * @return true The logging is asynchronous.
+           * @return false The logging is synchronous.
+           */
+          bool isAsync() const
+          {
+            return _asyncRunning.load();
+          }
+          /**
+           * @brief Gets the number of the posts lost because of a full asynchronous queue.
+           * 
+           * @return size_t The number of the lost posts.
+           */
+          size_t droppedPosts() const
+          {
+            return _asyncDropped.load();
+          }
+          /**
+           * @brief Gets the number of the posts thrown away by the rate limits and the sampling.
+           * 
+           * @return size_t The number of the suppressed posts.
+           */
+          size_t suppressedPosts() const
+          {
+            return _suppressed.load(std::memory_order_relaxed);
+          }
+
+        // Metrics ----
+          /**
+           * @brief Gets the counters of the logging and of every channel.
+           * 
+           * @return LogMetrics Snapshot of the counters.
+           */
+          LogMetrics metrics()
+          {
+            LogMetrics metrics;
+            // Sum of the threads (the finished ones are in the retired counters)
+            {
+              std::lock_guard<std::mutex> lock(_countersMutex);
+              auto add = [&metrics](const LevelCounters& counters)
+                {
+                  for(size_t i = 0; i < 4; ++i)
+                  {
+                    metrics.accepted[i] += counters.accepted[i].load(std::memory_order_relaxed);
+                    metrics.filtered[i] += counters.filtered[i].load(std::memory_order_relaxed);
+                  }
+                };
+              add(_retiredCounters);
+              for(const LevelCounters* counters : _threadCounters) add(*counters);
+            }
+            metrics.suppressed = _suppressed.load(std::memory_order_relaxed);
+            metrics.dropped = _asyncDropped.load(std::memory_order_relaxed);
+            // The channels
+            for(auto& [id, channel] : *_logChannels.load())
+            {
+              metrics.channels.push_back(channel->metrics());
+              metrics.channels.back().id = id;
+            }
+            return metrics;
+          }
+          /**
+           * @brief Switches the time measurements of the metrics (the lock waits and the write() times of the channels).
+           * @details The counters are always on, the times cost two clock reads per write, so they are off by default.
+           * 
+           * @param enabled Should we measure the times.
+           */
+          void metricsTiming(bool enabled)
+          {
+            _metricsTiming.store(enabled);
+          }
+          /**
+           * @brief Gets if the time measurements of the metrics are on.
+           * 
+           * @return true The times are measured.
+           * @return false Only the counters work.
+           */
+          bool metricsTiming() const
+          {
+            return _metricsTiming.load();
+          }
+
+        // Rate limits ----
+          /**
+           * @brief Sets the rate limit (and sampling) of the posts of a sender with a message type.
+           * @details The limit is checked before the post is formatted. An empty sender sets the default limit:
+           * every sender without its own limit gets its own copy of it (at its first post of the type). The copies of only
+           * the DEFAULT_LIMITER_CAPACITY most recently posting senders are kept, so dynamic sender names don't grow the list.
+           * 
+           * @param sender The sender (empty = every other sender).
+           * @param type Type of the posts.
+           * @param limit The limit.
+           */
+          void setRateLimit(std::string_view sender, MsgType type, const RateLimit& limit)
+          {
+            // Only one modification at a time
+            std::lock_guard<std::mutex> lock(_registryMutex);
+            // Put the limit into a copy of the list
+            std::shared_ptr<LimitMap> newLimits = std::make_shared<LimitMap>(*_rateLimits.load());
+            (*newLimits)[std::string(sender)][type] = std::make_shared<Limiter>(limit);
+            // Publish the new list
+            _rateLimits.store(newLimits);
+            _rateLimited.store(true);
+            // The copies of the old default are dropped
+            if(sender.empty()) _dropDefaultLimiters(type);
+          }
+          /**
+           * @brief Removes the rate limit of the posts of a sender with a message type.
+           * 
+           * @param sender The sender (empty = the limit of every other sender).
+           * @param type Type of the posts.
+           */
+          void removeRateLimit(std::string_view sender, MsgType type)
+          {
+            // Only one modification at a time
+            std::lock_guard<std::mutex> lock(_registryMutex);
+            // Remove the limit from a copy of the list
+            std::shared_ptr<LimitMap> newLimits = std::make_shared<LimitMap>(*_rateLimits.load());
+            auto senderLimits = newLimits->find(sender);
+            if(senderLimits == newLimits->end() || senderLimits->second.erase(type) == 0)
+            {
+              std::cerr << "!!!--> We don't have a rate limit for '" << sender << "' <--!!!" << std::endl;
+              return;
+            }
+            if(senderLimits->second.empty()) newLimits->erase(senderLimits);
+            // Publish the new list
+            _rateLimits.store(newLimits);
+            _rateLimited.store(!newLimits->empty());
+            // The copies of the default are dropped too
+            if(sender.empty()) _dropDefaultLimiters(type);
+          }
+
+        // Senders ----
+          /**
+           * @brief Interns a sender name.
+           * @details The name is copied once and kept as long as the Log lives. The posts of the returned
+           * Sender don't copy the name, and the channels can cache things by its id. Interning the same
+           * name again gives back the same Sender.
+           * 
+           * @param name Name of the sender.
+           * @return Sender The interned sender.
+           */
+          Sender sender(std::string_view name)
+          {
+            // Only one modification at a time
+            std::lock_guard<std::mutex> lock(_registryMutex);
+            // Check if we know it
+            auto known = _senderIds.find(name);
+            if(known != _senderIds.end()) return Sender { known->second, _senderNames[known->second - 1] };
+            // Store it (the deque doesn't move its elements, so the views stay valid)
+            _senderNames.emplace_back(name);
+            uint32_t id = uint32_t(_senderNames.size());
+            _senderIds.emplace(_senderNames.back(), id);
+            return Sender { id, _senderNames.back() };
           }
 
         // Messages ----
@@ -340,61 +1454,387 @@ namespace drLog {
            * @param sender The sender of the post.
            * @param type Type of the post.
            * @param level The level of the post.
+           * @param location Where the message is posted (filled by the compiler).
            * @return LogPost The custom LogPost.
            */  
-          LogPost msg(const std::string& sender, MsgLevel level=MsgLevel::MSG_L_LOW, MsgType type=MsgType::LOG_MSG)
+          LogPost msg(std::string_view sender, MsgLevel level=MsgLevel::MSG_L_LOW, MsgType type=MsgType::LOG_MSG, std::source_location location=std::source_location::current())
           {
-            return LogPost(*this, sender, level, type);
+            return LogPost(*this, sender, level, type, levelCompiled(level) && _accept(sender, level, type), location);
+          }
+          /**
+           * @brief Creates a custom log post of an interned sender.
+           * 
+           * @param sender The interned sender of the post.
+           * @param type Type of the post.
+           * @param level The level of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return LogPost The custom LogPost.
+           */  
+          LogPost msg(const Sender& sender, MsgLevel level=MsgLevel::MSG_L_LOW, MsgType type=MsgType::LOG_MSG, std::source_location location=std::source_location::current())
+          {
+            return LogPost(*this, sender, level, type, levelCompiled(level) && _accept(sender.name, level, type), location);
+          }
+          /**
+           * @brief Creates a custom log post with a compile time level (stripped under DRLOG_MIN_LEVEL).
+           * 
+           * @tparam Level The level of the post.
+           * @param sender The sender of the post.
+           * @param type Type of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<Level> The custom LogPost (or a NullPost).
+           */
+          template<MsgLevel Level>
+          Post<Level> msg(std::string_view sender, MsgType type=MsgType::LOG_MSG, std::source_location location=std::source_location::current())
+          {
+            return _levelPost<Level>(sender, type, location);
+          }
+          /**
+           * @brief Creates a custom log post of an interned sender with a compile time level (stripped under DRLOG_MIN_LEVEL).
+           * 
+           * @tparam Level The level of the post.
+           * @param sender The interned sender of the post.
+           * @param type Type of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<Level> The custom LogPost (or a NullPost).
+           */
+          template<MsgLevel Level>
+          Post<Level> msg(const Sender& sender, MsgType type=MsgType::LOG_MSG, std::source_location location=std::source_location::current())
+          {
+            return _levelPost<Level>(sender, type, location);
           }
           /**
            * @brief Creates a 'info' log post.
            * 
            * @param sender The sender of the post.
-           * @return LogPost The custom LogPost.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_MEDIUM> The custom LogPost (or a NullPost if the level is stripped).
            */
-          LogPost info(const std::string& sender)
+          Post<MsgLevel::MSG_L_MEDIUM> info(std::string_view sender, std::source_location location=std::source_location::current())
           {
             // Call msg with the proper parameters
-            return msg(sender, MsgLevel::MSG_L_MEDIUM, MsgType::LOG_INFO);
+            return _levelPost<MsgLevel::MSG_L_MEDIUM>(sender, MsgType::LOG_INFO, location);
+          }
+          /**
+           * @brief Creates a 'info' log post.
+           * 
+           * @param sender The interned sender of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_MEDIUM> The custom LogPost (or a NullPost if the level is stripped).
+           */
+          Post<MsgLevel::MSG_L_MEDIUM> info(const Sender& sender, std::source_location location=std::source_location::current())
+          {
+            // Call msg with the proper parameters
+            return _levelPost<MsgLevel::MSG_L_MEDIUM>(sender, MsgType::LOG_INFO, location);
           }
           /**
            * @brief Creates a 'warning' log post.
            * 
            * @param sender The sender of the post.
-           * @return LogPost The custom LogPost.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_MEDIUM> The custom LogPost (or a NullPost if the level is stripped).
            */
-          LogPost warning(const std::string& sender)
+          Post<MsgLevel::MSG_L_MEDIUM> warning(std::string_view sender, std::source_location location=std::source_location::current())
           {
             // Call msg with the proper parameters
-            return msg(sender, MsgLevel::MSG_L_MEDIUM, MsgType::LOG_WARNING);
+            return _levelPost<MsgLevel::MSG_L_MEDIUM>(sender, MsgType::LOG_WARNING, location);
+          }
+          /**
+           * @brief Creates a 'warning' log post.
+           * 
+           * @param sender The interned sender of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_MEDIUM> The custom LogPost (or a NullPost if the level is stripped).
+           */
+          Post<MsgLevel::MSG_L_MEDIUM> warning(const Sender& sender, std::source_location location=std::source_location::current())
+          {
+            // Call msg with the proper parameters
+            return _levelPost<MsgLevel::MSG_L_MEDIUM>(sender, MsgType::LOG_WARNING, location);
           }
           /**
            * @brief Creates a 'error' log post.
            * 
            * @param sender The sender of the post.
-           * @return LogPost The custom LogPost.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_HIGH> The custom LogPost (or a NullPost if the level is stripped).
            */
-          LogPost error(const std::string& sender)
+          Post<MsgLevel::MSG_L_HIGH> error(std::string_view sender, std::source_location location=std::source_location::current())
           {
             // Call msg with the proper parameters
-            return msg(sender, MsgLevel::MSG_L_HIGH, MsgType::LOG_ERROR);
+            return _levelPost<MsgLevel::MSG_L_HIGH>(sender, MsgType::LOG_ERROR, location);
+          }
+          /**
+           * @brief Creates a 'error' log post.
+           * 
+           * @param sender The interned sender of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_HIGH> The custom LogPost (or a NullPost if the level is stripped).
+           */
+          Post<MsgLevel::MSG_L_HIGH> error(const Sender& sender, std::source_location location=std::source_location::current())
+          {
+            // Call msg with the proper parameters
+            return _levelPost<MsgLevel::MSG_L_HIGH>(sender, MsgType::LOG_ERROR, location);
           }
           /**
            * @brief Creates a 'debug' log post.
            * 
            * @param sender The sender of the post.
-           * @return LogPost The custom LogPost.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_DEBUG> The custom LogPost (or a NullPost if the level is stripped).
+           */
+          Post<MsgLevel::MSG_L_DEBUG> debug(std::string_view sender, std::source_location location=std::source_location::current())
+          {
+            // Call msg with the proper parameters
+            return _levelPost<MsgLevel::MSG_L_DEBUG>(sender, MsgType::LOG_DEBUG, location);
+          }
+          /**
+           * @brief Creates a 'debug' log post.
+           * 
+           * @param sender The interned sender of the post.
+           * @param location Where the message is posted (filled by the compiler).
+           * @return Post<MsgLevel::MSG_L_DEBUG> The custom LogPost (or a NullPost if the level is stripped).
            */
-          LogPost debug(const std::string& sender)
+          Post<MsgLevel::MSG_L_DEBUG> debug(const Sender& sender, std::source_location location=std::source_location::current())
           {
             // Call msg with the proper parameters
-            return msg(sender, MsgLevel::MSG_L_DEBUG, MsgType::LOG_DEBUG);
+            return _levelPost<MsgLevel::MSG_L_DEBUG>(sender, MsgType::LOG_DEBUG, location);
           }
       
       private:
+        // Functions ----
+          /**
+           * @brief Creates a post with a compile time level.
+           * 
+           * @tparam Level The level of the post.
+           * @tparam S Type of the sender (a name or an interned Sender).
+           * @param sender The sender of the post.
+           * @param type Type of the post.
+           * @param location Where the message is posted.
+           * @return Post<Level> The LogPost, or a NullPost if the level is stripped.
+           */
+          template<MsgLevel Level, typename S>
+          Post<Level> _levelPost(const S& sender, MsgType type, std::source_location location)
+          {
+            if constexpr (levelCompiled(Level)) return msg(sender, Level, type, location);
+            else return NullPost();
+          }
+
+        // Constants ----
+          static constexpr size_t                   DEFAULT_LIMITER_SHARDS    = 16;         // Number of the locks of the copies of the default rate limits.
+          static constexpr size_t                   DEFAULT_LIMITER_CAPACITY  = 4096;       // Most senders with own copies of the default rate limits (the least recently posting ones are dropped).
+
+        // Types ----
+          using ChannelMap = std::map<int, std::shared_ptr<LogChannel>>;
+          struct Limiter;
+          using LimitMap = std::map<std::string, std::map<MsgType, std::shared_ptr<Limiter>>, std::less<>>;
+
+        // Structures ----
+          /**
+           * @brief Post counters by MsgLevel (written only by their own thread).
+           * 
+           */
+          struct LevelCounters
+          {
+            std::array<std::atomic<uint64_t>, 4>    accepted        = {};               // Posts sent to the channels.
+            std::array<std::atomic<uint64_t>, 4>    filtered        = {};               // Posts thrown away.
+          };
+          /**
+           * @brief The counters of a thread (registered in the Log while the thread lives).
+           * 
+           */
+          struct ThreadCounters
+          {
+            LevelCounters               counters;                                       // The counters.
+
+            /**
+             * @brief Constructs a new ThreadCounters object and registers it.
+             * 
+             */
+            ThreadCounters()
+            {
+              Log& log = getInstance();
+              std::lock_guard<std::mutex> lock(log._countersMutex);
+              log._threadCounters.push_back(&counters);
+            }
+            /**
+             * @brief Destroys the ThreadCounters object (moving its counts into the retired counters).
+             * 
+             */
+            ~ThreadCounters()
+            {
+              Log& log = getInstance();
+              std::lock_guard<std::mutex> lock(log._countersMutex);
+              for(size_t i = 0; i < 4; ++i)
+              {
+                log._retiredCounters.accepted[i].fetch_add(counters.accepted[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                log._retiredCounters.filtered[i].fetch_add(counters.filtered[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+              }
+              std::erase(log._threadCounters, &counters);
+            }
+          };
+          /**
+           * @brief State of a rate limit (lock-free, shared by the posting threads).
+           * @details The token bucket is a GCRA: the theoretical arrival time steps an interval forward with every
+           * accepted post, and a post is accepted if it is not further ahead of now than the burst allows.
+           * 
+           */
+          struct Limiter
+          {
+            RateLimit                   limit;                                          // The settings.
+            int64_t                     interval          = 0;                          // Nanoseconds between two posts at the average rate.
+            int64_t                     tolerance         = 0;                          // How far the arrival time can be ahead of now (the burst).
+            std::atomic<int64_t>        arrivalTime       = 0;                          // The theoretical arrival time of the next post.
+            std::atomic<size_t>         sampleCounter     = 0;                          // Counter of the sampling.
+            std::atomic<size_t>         suppressed        = 0;                          // Posts thrown away since the last summary.
+            std::atomic<int64_t>        nextSummary       = 0;                          // When we can report the suppressed posts again.
+
+            /**
+             * @brief Constructs a new Limiter object.
+             * 
+             * @param rateLimit The settings.
+             */
+            Limiter(const RateLimit& rateLimit)
+              :
+                limit(rateLimit)
+            {
+              if(limit.ratePerSecond > 0)
+              {
+                interval = int64_t(1e9 / limit.ratePerSecond);
+                tolerance = interval * int64_t(limit.burst > 0 ? limit.burst - 1 : 0);
+              }
+              // The first summary comes after a full interval
+              int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+              nextSummary.store(now + int64_t(limit.summaryIntervalMs) * 1000000);
+            }
+            /**
+             * @brief Decides if a post goes through.
+             * 
+             * @param now Current time (steady clock nanoseconds).
+             * @return true The post goes through.
+             * @return false The post is suppressed.
+             */
+            bool admit(int64_t now)
+            {
+              // Sampling
+              if(limit.sampleEvery > 1 && sampleCounter.fetch_add(1, std::memory_order_relaxed) % limit.sampleEvery != 0) return false;
+              // No rate limit
+              if(interval == 0) return true;
+              // Token bucket
+              int64_t arrival = arrivalTime.load(std::memory_order_relaxed);
+              while(true)
+              {
+                int64_t start = std::max(arrival, now);
+                // Too far ahead: no token for this post
+                if(start - now > tolerance) return false;
+                if(arrivalTime.compare_exchange_weak(arrival, start + interval, std::memory_order_relaxed)) return true;
+              }
+            }
+          };
+          /**
+           * @brief The copies of the default rate limits of a sender.
+           * 
+           */
+          struct SenderLimiters
+          {
+            std::string                 sender;                                         // The sender.
+            std::map<MsgType, std::unique_ptr<Limiter>> limiters;                       // Its limiters by type.
+          };
+          /**
+           * @brief A part of the copies of the default rate limits (by the hash of the senders), with its own lock.
+           * 
+           */
+          struct LimiterShard
+          {
+            std::mutex                  mutex;                                          // Lock of the shard.
+            std::list<SenderLimiters>   recent;                                         // The senders, the most recently posting one first.
+            std::map<std::string_view, std::list<SenderLimiters>::iterator> index;      // The senders by name (the names are in the list).
+          };
+          /**
+           * @brief A summary of suppressed posts to report.
+           * 
+           */
+          struct SuppressedSummary
+          {
+            std::string                 sender;                                         // The sender.
+            MsgType                     type              = MsgType::LOG_MSG;           // Type of the posts.
+            size_t                      suppressed        = 0;                          // Number of the suppressed posts.
+          };
+          /**
+           * @brief A post waiting in the asynchronous queue.
+           * 
+           */
+          struct AsyncPost
+          {
+            std::string                 className;                                      // Name of the sender class.
+            std::string                 message;                                        // The message.
+            MsgLevel                    level             = MsgLevel::MSG_L_LOW;        // Level of the message.
+            MsgType                     type              = MsgType::LOG_MSG;           // Type of the message.
+            std::chrono::system_clock::time_point   dateTime;                           // The datetime of the post.
+            std::array<LogField, LogPost::MAX_FIELDS>   fields;                         // The structured fields.
+            size_t                      fieldCount        = 0;                          // Number of the structured fields.
+            std::string                 fieldText;                                      // Keys and string values of the fields.
+            uint32_t                    senderId          = 0;                          // ID of the interned sender (its name is not copied).
+            std::string_view            senderName;                                     // Name of the interned sender.
+            std::source_location        location;                                       // Where the message was posted.
+
+            /**
+             * @brief Gets the record of the post.
+             * 
+             * @return LogRecord The record (it views the strings of the post).
+             */
+            LogRecord record() const
+            {
+              return LogRecord { senderId != 0 ? senderName : std::string_view(className), message, level, type, dateTime, std::span<const LogField>(fields.data(), fieldCount), senderId, location };
+            }
+            /**
+             * @brief Copies the fields of a record (with their strings).
+             * 
+             * @param recordFields The fields of the record.
+             */
+            void setFields(std::span<const LogField> recordFields)
+            {
+              // Size of the strings (so the buffer doesn't grow under the views)
+              size_t size = 0;
+              for(const LogField& field : recordFields) size += field.key.size() + field.stringValue.size();
+              fieldText.clear();
+              fieldText.reserve(size);
+              // Copy the fields
+              fieldCount = std::min(recordFields.size(), fields.size());
+              for(size_t i = 0; i < fieldCount; ++i)
+              {
+                fields[i] = recordFields[i];
+                fields[i].key = std::string_view(fieldText.data() + fieldText.size(), recordFields[i].key.size());
+                fieldText.append(recordFields[i].key);
+                if(fields[i].type == FieldType::FIELD_STRING)
+                {
+                  fields[i].stringValue = std::string_view(fieldText.data() + fieldText.size(), recordFields[i].stringValue.size());
+                  fieldText.append(recordFields[i].stringValue);
+                }
+              }
+            }
+          };
+
         // Variables ----
-          std::mutex                                        _writeMutex;        // A mutex for preventing writing channels simultaneously.
-          std::map<int, std::shared_ptr<LogChannel>>        _logChannels;       // A container for the logging channels.
+          std::mutex                                        _registryMutex;                 // Serializes the modifications of the channel list.
+          std::atomic<std::shared_ptr<const ChannelMap>>    _logChannels      = std::make_shared<const ChannelMap>(); // The current (immutable) list of the logging channels.
+          std::unique_ptr<Utils::RingBuffer<AsyncPost>>     _asyncQueue;                    // Queue of the asynchronous posts.
+          std::thread                                       _asyncWriter;                   // Thread that writes the asynchronous posts.
+          AsyncOverflow                                     _asyncOverflow    = AsyncOverflow::ASYNC_BLOCK; // Behaviour on full queue.
+          std::atomic<bool>                                 _asyncRunning     = false;      // Is the asynchronous mode running.
+          std::atomic<size_t>                               _asyncPushed      = 0;          // Number of the posts put into the queue.
+          std::atomic<size_t>                               _asyncDone        = 0;          // Number of the posts written (or overwritten) from the queue.
+          std::atomic<size_t>                               _asyncDropped     = 0;          // Number of the posts lost because of the full queue.
+          std::atomic<unsigned int>                         _minLevel         = 4;          // The lowest level any channel accepts (above every level without channels).
+          std::atomic<std::shared_ptr<const LimitMap>>      _rateLimits       = std::make_shared<const LimitMap>(); // The current (immutable) list of the rate limits.
+          std::atomic<bool>                                 _rateLimited      = false;      // Do we have any rate limit.
+          std::atomic<size_t>                               _suppressed       = 0;          // Number of the posts thrown away by the rate limits.
+          std::array<LimiterShard, DEFAULT_LIMITER_SHARDS>  _defaultLimiters;               // The copies of the default rate limits of the senders.
+          std::atomic<int64_t>                              _nextSummarySweep = 0;          // When we look for the overdue summaries again.
+          std::atomic<bool>                                 _metricsTiming    = false;      // Do we measure the times of the metrics.
+          std::deque<std::string>                           _senderNames;                   // Names of the interned senders (index = id - 1).
+          std::map<std::string_view, uint32_t>              _senderIds;                     // IDs of the interned senders.
+          std::mutex                                        _countersMutex;                 // Guards the list of the thread counters.
+          std::vector<LevelCounters*>                       _threadCounters;                // Counters of the living threads.
+          LevelCounters                                     _retiredCounters;               // Counters of the finished threads.
 
         // Construction ----
           /**
@@ -406,31 +1846,461 @@ namespace drLog {
            * @brief Destroys the Log object.
            * 
            */
-          ~Log() = default;
+          ~Log()
+          {
+            // Write out the queue before we go
+            stopAsync();
+          }
 
         // Functions ----
+          /**
+           * @brief Decides if a post goes to the channels (and counts it).
+           * 
+           * @param sender Name of the sender.
+           * @param level Level of the post.
+           * @param type Type of the post.
+           * @return true The post is formatted and sent.
+           * @return false The post is thrown away.
+           */
+          bool _accept(std::string_view sender, MsgLevel level, MsgType type)
+          {
+            // The rate limits are checked only for posts that would be written
+            bool enabled = isEnabled(level) && (!_rateLimited.load(std::memory_order_relaxed) || _admit(sender, type));
+            // Count it (on the counters of the thread, so the threads don't fight for a cache line)
+            std::atomic<uint64_t>& counter = enabled ? _localCounters().accepted[std::min<size_t>(size_t(level), 3)] : _localCounters().filtered[std::min<size_t>(size_t(level), 3)];
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return enabled;
+          }
+          /**
+           * @brief Gets the post counters of the current thread.
+           * 
+           * @return LevelCounters& The counters.
+           */
+          static LevelCounters& _localCounters()
+          {
+            // A plain pointer is cheaper to reach than an object with a constructor
+            thread_local LevelCounters* counters = nullptr;
+            if(counters) [[likely]] return *counters;
+            // The first post of the thread registers its counters
+            thread_local ThreadCounters registration;
+            counters = &registration.counters;
+            return *counters;
+          }
+          /**
+           * @brief Recalculates the lowest level that any of the channels accepts (when a channel changes its level).
+           * 
+           */
+          void _refreshMinLevel()
+          {
+            std::lock_guard<std::mutex> lock(_registryMutex);
+            _updateMinLevel();
+          }
+          /**
+           * @brief Recalculates the lowest level that any of the channels accepts (_registryMutex has to be locked).
+           * 
+           */
+          void _updateMinLevel()
+          {
+            // Without channels nothing is accepted
+            unsigned int minLevel = 4;
+            // Searching for the lowest level
+            for (auto& [name, channel] : *_logChannels.load())
+            {
+              minLevel = std::min(minLevel, (unsigned int)(channel->logLevel()));
+            }
+            // Store it
+            _minLevel.store(minLevel, std::memory_order_relaxed);
+          }
+          /**
+           * @brief Checks the rate limit of a post (and reports the suppressed posts if it is time).
+           * 
+           * @param sender The sender of the post.
+           * @param type Type of the post.
+           * @return true The post goes through.
+           * @return false The post is suppressed.
+           */
+          bool _admit(std::string_view sender, MsgType type)
+          {
+            std::shared_ptr<const LimitMap> limits = _rateLimits.load();
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            // Report the storms which have stopped (once a second, by one thread)
+            int64_t sweep = _nextSummarySweep.load(std::memory_order_relaxed);
+            if(now >= sweep && _nextSummarySweep.compare_exchange_strong(sweep, now + 1000000000, std::memory_order_relaxed)) _reportSuppressedPosts(true, now);
+            // The own limit of the sender
+            bool admitted = true;
+            if(Limiter* limiter = _findLimiter(*limits, sender, type))
+            {
+              size_t summary = _checkLimiter(*limiter, now, admitted);
+              if(summary > 0) _sendSuppressedSummary(sender, type, summary);
+              return admitted;
+            }
+            // No default limit either
+            Limiter* defaultLimiter = _findLimiter(*limits, std::string_view(), type);
+            if(!defaultLimiter || sender.empty()) return true;
+            // The sender gets its own copy of the default (so a storm of a sender doesn't suppress the others)
+            LimiterShard& shard = _defaultLimiters[std::hash<std::string_view>()(sender) % DEFAULT_LIMITER_SHARDS];
+            size_t summary = 0;
+            std::vector<SuppressedSummary> dropped;
+            {
+              std::lock_guard<std::mutex> lock(shard.mutex);
+              auto known = shard.index.find(sender);
+              if(known == shard.index.end())
+              {
+                // Drop the least recently posting sender if the shard is full (its suppressed posts are reported)
+                if(shard.recent.size() >= DEFAULT_LIMITER_CAPACITY / DEFAULT_LIMITER_SHARDS)
+                {
+                  SenderLimiters& oldest = shard.recent.back();
+                  _takeSuppressed(oldest, false, now, dropped);
+                  shard.index.erase(oldest.sender);
+                  shard.recent.pop_back();
+                }
+                shard.recent.emplace_front();
+                shard.recent.front().sender = std::string(sender);
+                known = shard.index.emplace(shard.recent.front().sender, shard.recent.begin()).first;
+              }
+              // The most recently posting one goes to the front
+              else shard.recent.splice(shard.recent.begin(), shard.recent, known->second);
+              std::unique_ptr<Limiter>& limiter = known->second->limiters[type];
+              if(!limiter) limiter = std::make_unique<Limiter>(defaultLimiter->limit);
+              summary = _checkLimiter(*limiter, now, admitted);
+            }
+            // Report outside of the lock
+            for(const SuppressedSummary& item : dropped) _sendSuppressedSummary(item.sender, item.type, item.suppressed);
+            if(summary > 0) _sendSuppressedSummary(sender, type, summary);
+            return admitted;
+          }
+          /**
+           * @brief Checks a post with a limiter, and takes its suppressed posts if their summary is due.
+           * 
+           * @param limiter The limiter.
+           * @param now Current time (steady clock nanoseconds).
+           * @param admitted The post goes through.
+           * @return size_t Number of the suppressed posts to report (0 = no summary now).
+           */
+          size_t _checkLimiter(Limiter& limiter, int64_t now, bool& admitted)
+          {
+            admitted = limiter.admit(now);
+            if(!admitted)
+            {
+              limiter.suppressed.fetch_add(1, std::memory_order_relaxed);
+              _suppressed.fetch_add(1, std::memory_order_relaxed);
+            }
+            return _takeDueSuppressed(limiter, now);
+          }
+          /**
+           * @brief Takes the suppressed posts of a limiter if their summary is due (only one thread wins them).
+           * 
+           * @param limiter The limiter.
+           * @param now Current time (steady clock nanoseconds).
+           * @return size_t Number of the suppressed posts (0 = not due).
+           */
+          static size_t _takeDueSuppressed(Limiter& limiter, int64_t now)
+          {
+            int64_t nextSummary = limiter.nextSummary.load(std::memory_order_relaxed);
+            if(now < nextSummary || limiter.suppressed.load(std::memory_order_relaxed) == 0) return 0;
+            if(!limiter.nextSummary.compare_exchange_strong(nextSummary, now + int64_t(limiter.limit.summaryIntervalMs) * 1000000, std::memory_order_relaxed)) return 0;
+            return limiter.suppressed.exchange(0, std::memory_order_relaxed);
+          }
+          /**
+           * @brief Takes the suppressed posts of the limiters of a sender (the shard has to be locked).
+           * 
+           * @param limiters The limiters of the sender.
+           * @param dueOnly Only the ones whose summary is due.
+           * @param now Current time (steady clock nanoseconds).
+           * @param summaries The summaries to report.
+           */
+          static void _takeSuppressed(SenderLimiters& limiters, bool dueOnly, int64_t now, std::vector<SuppressedSummary>& summaries)
+          {
+            for(auto& [type, limiter] : limiters.limiters)
+            {
+              size_t suppressed = dueOnly ? _takeDueSuppressed(*limiter, now) : limiter->suppressed.exchange(0, std::memory_order_relaxed);
+              if(suppressed > 0) summaries.push_back( { limiters.sender, type, suppressed } );
+            }
+          }
+          /**
+           * @brief Finds the limiter of a sender with a message type.
+           * 
+           * @param limits The list of the limits.
+           * @param sender The sender.
+           * @param type Type of the posts.
+           * @return Limiter* The limiter (or nullptr).
+           */
+          static Limiter* _findLimiter(const LimitMap& limits, std::string_view sender, MsgType type)
+          {
+            auto senderLimits = limits.find(sender);
+            if(senderLimits == limits.end()) return nullptr;
+            auto limiter = senderLimits->second.find(type);
+            return limiter == senderLimits->second.end() ? nullptr : limiter->second.get();
+          }
+          /**
+           * @brief Drops the copies of the default limit of a message type (reporting their suppressed posts).
+           * 
+           * @param type Type of the posts.
+           */
+          void _dropDefaultLimiters(MsgType type)
+          {
+            std::vector<SuppressedSummary> summaries;
+            for(LimiterShard& shard : _defaultLimiters)
+            {
+              std::lock_guard<std::mutex> lock(shard.mutex);
+              for(SenderLimiters& limiters : shard.recent)
+              {
+                auto limiter = limiters.limiters.find(type);
+                if(limiter == limiters.limiters.end()) continue;
+                size_t suppressed = limiter->second->suppressed.exchange(0, std::memory_order_relaxed);
+                if(suppressed > 0) summaries.push_back( { limiters.sender, type, suppressed } );
+                limiters.limiters.erase(limiter);
+              }
+            }
+            for(const SuppressedSummary& item : summaries) _sendSuppressedSummary(item.sender, item.type, item.suppressed);
+          }
+          /**
+           * @brief Sends a summary post about the suppressed posts of a sender.
+           * 
+           * @param sender The sender of the suppressed posts.
+           * @param type Type of the suppressed posts.
+           * @param suppressed Number of the suppressed posts.
+           */
+          void _sendSuppressedSummary(std::string_view sender, MsgType type, size_t suppressed)
+          {
+            // The summary with the details as fields
+            std::string message = "Suppressed " + std::to_string(suppressed) + " " + getMsgTypeStr(type) + " posts of <" + std::string(sender) + ">";
+            std::string typeName = getMsgTypeStr(type);
+            LogField fields[3];
+            fields[0].key = "suppressed";
+            fields[0].type = FieldType::FIELD_UINT;
+            fields[0].uintValue = suppressed;
+            fields[1].key = "sender";
+            fields[1].type = FieldType::FIELD_STRING;
+            fields[1].stringValue = sender;
+            fields[2].key = "type";
+            fields[2].type = FieldType::FIELD_STRING;
+            fields[2].stringValue = typeName;
+            LogRecord record { .className = "drLog", .message = message, .level = MsgLevel::MSG_L_HIGH, .type = MsgType::LOG_WARNING,
+                               .dateTime = {}, .fields = fields, .senderId = 0, .location = std::source_location() };
+            _sendToChannels(record);
+          }
+          /**
+           * @brief Reports the suppressed posts of the limiters.
+           * 
+           * @param dueOnly Only the ones whose summary is due.
+           * @param now Current time (steady clock nanoseconds).
+           */
+          void _reportSuppressedPosts(bool dueOnly, int64_t now)
+          {
+            std::vector<SuppressedSummary> summaries;
+            // The own limits of the senders
+            for(auto& [sender, senderLimits] : *_rateLimits.load())
+            {
+              for(auto& [type, limiter] : senderLimits)
+              {
+                size_t suppressed = dueOnly ? _takeDueSuppressed(*limiter, now) : limiter->suppressed.exchange(0, std::memory_order_relaxed);
+                if(suppressed > 0) summaries.push_back( { sender, type, suppressed } );
+              }
+            }
+            // The copies of the defaults
+            for(LimiterShard& shard : _defaultLimiters)
+            {
+              std::lock_guard<std::mutex> lock(shard.mutex);
+              for(SenderLimiters& limiters : shard.recent) _takeSuppressed(limiters, dueOnly, now, summaries);
+            }
+            for(const SuppressedSummary& item : summaries) _sendSuppressedSummary(item.sender, item.type, item.suppressed);
+          }
+          /**
+           * @brief Reports the suppressed posts of every limiter.
+           * 
+           */
+          void _reportAllSuppressed()
+          {
+            _reportSuppressedPosts(false, 0);
+          }
           /**
            * @brief Sending message to the channels.
            * 
-           * @param className Name of the sender class.
-           * @param message Message we want to write
-           * @param level Level of the message.
-           * @param type Type of the message. 
+           * @param record The record of the post (its time is set here).
+           */
+          void _sendToChannels(LogRecord& record)
+          {
+            // The time of the post
+            record.dateTime = std::chrono::system_clock::now();
+            // In asynchronous mode we only put it into the queue
+            if(_asyncRunning.load(std::memory_order_relaxed))
+            {
+              _pushAsync(record);
+              return;
+            }
+            // Otherwise we write it immediately
+            _writeToChannels(record);
+          }
+          /**
+           * @brief Writing a record into the channels.
+           * 
+           * @param record The record we want to write.
+           */
+          void _writeToChannels(const LogRecord& record)
+          {
+            // Take the current list (it can't change under us, and we don't block the modifications)
+            std::shared_ptr<const ChannelMap> channels = _logChannels.load();
+            // Going through channels
+            for (auto& [name, channel] : *channels)
+            {
+              // Write channel logs (every channel has its own lock)
+              channel->_post(record);
+            }
+          }
+          /**
+           * @brief Flushes every channel.
+           * 
            */
-          void _sendToChannels(std::string className, std::string message, MsgLevel level, MsgType type)
+          void _flushChannels()
           {
-              // Lock the mutex
-              std::lock_guard<std::mutex> lock(_writeMutex);
-              // Going through channels
-              for (auto& [name, channel] : _logChannels)
+            // Take the current list
+            std::shared_ptr<const ChannelMap> channels = _logChannels.load();
+            // Going through channels
+            for (auto& [name, channel] : *channels) channel->_flush();
+          }
+          /**
+           * @brief Puts a record into the asynchronous queue.
+           * 
+           * @param record The record we want to write.
+           */
+          void _pushAsync(const LogRecord& record)
+          {
+            // Fills a queue cell (assigning keeps the capacity of the strings in the cell)
+            auto fill = [&](AsyncPost& post)
+              {
+                // Interned senders live as long as the Log, we only keep their view
+                post.senderId = record.senderId;
+                if(record.senderId != 0) post.senderName = record.className;
+                else post.className.assign(record.className);
+                post.location = record.location;
+                post.message.assign(record.message);
+                post.level = record.level;
+                post.type = record.type;
+                post.dateTime = record.dateTime;
+                post.setFields(record.fields);
+              };
+            // Trying to put it into the queue
+            bool pushed = _asyncQueue->tryPush(fill);
+            // The queue is full
+            while(!pushed)
+            {
+              switch(_asyncOverflow)
               {
-                  // Write channel logs
-                  channel->write(className, message, level, type, std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+                case AsyncOverflow::ASYNC_DROP_NEWEST:
+                  // We lose this post
+                  _asyncDropped.fetch_add(1, std::memory_order_relaxed);
+                  return;
+                case AsyncOverflow::ASYNC_OVERWRITE_OLDEST:
+                  // Throwing away the oldest post to make room
+                  if(_asyncQueue->tryPop([](AsyncPost&) {}))
+                  {
+                    _asyncDropped.fetch_add(1, std::memory_order_relaxed);
+                    _asyncDone.fetch_add(1);
+                    _asyncDone.notify_all();
+                  }
+                  break;
+                default:
+                case AsyncOverflow::ASYNC_BLOCK:
+                {
+                  // Remember the progress of the writer before we retry (so we can't miss a wake up)
+                  size_t done = _asyncDone.load();
+                  // If it has been stopped meanwhile, we write it ourself
+                  if(!_asyncRunning.load())
+                  {
+                    _writeToChannels(record);
+                    return;
+                  }
+                  // Retry before going to sleep (the writer could be faster than us)
+                  if(_asyncQueue->tryPush(fill)) { pushed = true; break; }
+                  // Waiting for the writer to make some progress
+                  _asyncDone.wait(done);
+                  break;
+                }
+              }
+              // Trying again
+              if(!pushed) pushed = _asyncQueue->tryPush(fill);
+            }
+            // Count it and wake up the writer
+            _asyncPushed.fetch_add(1);
+            _asyncPushed.notify_one();
+          }
+          /**
+           * @brief The loop of the asynchronous writer thread.
+           * 
+           */
+          void _asyncWriterLoop()
+          {
+            // Writes a queued post into the channels
+            auto write = [this](AsyncPost& post) { _writeToChannels(post.record()); };
+            // Run until we are stopped
+            while(true)
+            {
+              // Remember the counter before we look into the queue (so we can't miss a wake up)
+              size_t pushed = _asyncPushed.load();
+              // Write everything we have
+              bool wrote = false;
+              while(_asyncQueue->tryPop(write))
+              {
+                wrote = true;
+                _asyncDone.fetch_add(1);
+                _asyncDone.notify_all();
               }
+              // Exit if we have been stopped (the queue is empty now)
+              if(!_asyncRunning.load()) return;
+              // Otherwise waiting for new posts
+              if(!wrote) _asyncPushed.wait(pushed);
+            }
           }
     
     };
 
+  // Out of class definitions ----
+    inline void LogChannel::logLevel(LogLevel newLevel)
+    {
+      // Set the level
+      p_LogLevel.store(newLevel, std::memory_order_relaxed);
+      // Tell the Log to refresh its filter
+      if(Log* owner = _owner.load()) owner->_refreshMinLevel();
+    }
+    inline bool LogChannel::_post(const LogRecord& record)
+    {
+      return p_countedWrite(record.level, [this, &record]{ return write(record); });
+    }
+    template<typename Writer>
+    inline bool LogChannel::p_countedWrite(MsgLevel level, Writer&& writer)
+    {
+      // Index of the counters
+      size_t index = std::min<size_t>(size_t(level), 3);
+      // Filtered by the level of the channel (it doesn't need the lock)
+      if(int(level) < int(logLevel()))
+      {
+        _counters.filtered[index].fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+      // Should we measure the times
+      Log* owner = _owner.load(std::memory_order_relaxed);
+      bool timing = owner && owner->_metricsTiming.load(std::memory_order_relaxed);
+      // Lock the channel (measuring the wait only if somebody else holds it)
+      std::unique_lock<std::mutex> lock(p_ChannelMutex, std::try_to_lock);
+      if(!lock.owns_lock())
+      {
+        auto start = timing ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        lock.lock();
+        if(timing) _counters.lockWaitNs.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+      }
+      _counters.accepted[index].fetch_add(1, std::memory_order_relaxed);
+      // Write it
+      if(!timing) return writer();
+      auto start = std::chrono::steady_clock::now();
+      bool result = writer();
+      uint64_t elapsed = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      // Bucket of the time (the position of its highest bit)
+      size_t bucket = elapsed > 1 ? std::min<size_t>(63 - size_t(__builtin_clzll(elapsed)), ChannelMetrics::LATENCY_BUCKETS - 1) : 0;
+      _counters.writeLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+      return result;
+    }
+
   // Log Channel ----
     /**
      * @brief Standard Output Channel for the logging.
@@ -447,48 +2317,184 @@ namespace drLog {
            * 
            * @param logLevel Level of the logging.
            * @param DTFormat DateTime format of the logging.
+           * @param policy Colouring and batching of the output.
            */
-          StdOutChannel(const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S")
+          StdOutChannel(const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S", const StdOutPolicy& policy = StdOutPolicy())
             :
-              drLog::LogChannel(logLevel, DTFormat)
-          {}
+              drLog::LogChannel(logLevel, DTFormat),
+              _policy(policy)
+          {
+            // Colours only go to a terminal (unless it is forced)
+            _colored = _policy.color == StdOutColor::COLOR_ALWAYS || (_policy.color == StdOutColor::COLOR_AUTO && ::isatty(STDOUT_FILENO));
+            // Reserve the buffer
+            _buffer.reserve(_policy.batchBytes > 0 ? _policy.batchBytes + 1024 : 1024);
+            _lastWrite = std::chrono::steady_clock::now();
+            // Timed writes need a thread (so the batch doesn't wait for the next line)
+            if(_policy.batchBytes > 0 && _policy.batchIntervalMs > 0) _writer = std::thread(&StdOutChannel::_writerLoop, this);
+          }
           /**
            * @brief Destroys the Standard Output Channel object.
            * 
            */
-          ~StdOutChannel() = default;
+          ~StdOutChannel()
+          {
+            // Stop the writer thread
+            if(_writer.joinable())
+            {
+              {
+                std::lock_guard<std::mutex> lock(p_ChannelMutex);
+                _stop = true;
+              }
+              _writerCondition.notify_all();
+              _writer.join();
+            }
+            // Write the rest
+            _writeBuffer();
+          }
 
         // Functions ----
           /**
            * @brief Writes the log.
            * 
-           * @param className Name of the sender class.
-           * @param message Message we want to write
-           * @param level Level of the message.
-           * @param type Type of the message.
-           * @param dateTime The datetime when we write it on the channel.
+           * @param record The record we want to write.
            * @return true Write has successed.
            * @return false Write has failed.
            */
-          bool write(std::string className, std::string message, MsgLevel level, MsgType type, const std::time_t& dateTime) override
+          bool write(const LogRecord& record) override
           {
             // If the message level is higher or the same we do the post
-            if(int(level)>=int(p_LogLevel))
+            if(int(record.level)>=int(logLevel()))
             {
-              // Formating and write the log
-              std::cout <<
-                "[" << Utils::DateTime::getTimeTInStr(dateTime, p_DTFormat) << "] - " <<                    // TimeStamp
-                "\033[" << std::to_string(int(type)) << "m[" + getMsgTypeStr(type) << "]\033[0m " <<        // Type
-                "<" << className << "> => " <<                                                              // Sender
-                message << "\n";                                                                            // Message
+              // Formating the line into the buffer
+              _buffer.push_back('[');
+              _buffer.append(p_TimeStamp.format(record.dateTime));
+              _buffer.append("] - ");
+              if(_colored)
+              {
+                // The message types are the colour codes
+                char code[16];
+                auto [end, ec] = std::to_chars(code, code + sizeof(code), int(record.type));
+                _buffer.append("\033[");
+                _buffer.append(code, end - code);
+                _buffer.push_back('m');
+              }
+              _buffer.push_back('[');
+              _buffer.append(getMsgTypeStr(record.type));
+              _buffer.append(_colored ? "]\033[0m <" : "] <");
+              _buffer.append(record.className);
+              _buffer.append("> => ");
+              _buffer.append(record.message);
+              appendFieldsText(_buffer, record.fields);
+              if(sourceLocation()) appendLocationText(_buffer, record.location);
+              _buffer.push_back('\n');
+              // Write it if we don't collect the lines or the batch is due
+              bool error = record.type == MsgType::LOG_ERROR && _policy.writeOnError;
+              if(_policy.batchBytes == 0 || error || _buffer.size() >= _policy.batchBytes || _intervalElapsed()) return _writeBuffer();
             }
             return true;
           }
-    
+          /**
+           * @brief Writes the collected lines to the standard output.
+           * 
+           */
+          void flush() override
+          {
+            _writeBuffer();
+          }
+
+      private:
+        // Variables ----
+          StdOutPolicy                            _policy;                  // Colouring and batching of the output.
+          bool                                    _colored        = false;  // Do we colour the message types.
+          std::string                             _buffer;                  // The lines waiting for the write.
+          std::chrono::steady_clock::time_point   _lastWrite;               // Time of the last write.
+          std::thread                             _writer;                  // Thread of the timed writes.
+          std::condition_variable                 _writerCondition;         // Wakes up the writer thread when we stop.
+          bool                                    _stop           = false;  // Stop sign for the writer thread.
+
+        // Functions ----
+          /**
+           * @brief Checks if the timed write is due.
+           * 
+           * @return true We have to write the batch.
+           * @return false We can wait.
+           */
+          bool _intervalElapsed() const
+          {
+            if(_policy.batchIntervalMs == 0) return false;
+            return std::chrono::steady_clock::now() - _lastWrite >= std::chrono::milliseconds(_policy.batchIntervalMs);
+          }
+          /**
+           * @brief Writes the buffer to the standard output with as few write(2) calls as possible.
+           * 
+           * @return true Write has successed.
+           * @return false Write has failed.
+           */
+          bool _writeBuffer()
+          {
+            _lastWrite = std::chrono::steady_clock::now();
+            // Nothing to write
+            if(_buffer.empty()) return true;
+            // Whatever is waiting in the stdio buffer (std::cout) goes first, so the order stays
+            std::fflush(stdout);
+            // Write it (a pipe can take it in pieces)
+            const char* data = _buffer.data();
+            size_t size = _buffer.size();
+            while(size > 0)
+            {
+              ssize_t written = ::write(STDOUT_FILENO, data, size);
+              if(written < 0)
+              {
+                // Interrupted, try again
+                if(errno == EINTR) continue;
+                // Failed, we drop the batch
+                p_addFailure();
+                _buffer.clear();
+                return false;
+              }
+              data += written;
+              size -= size_t(written);
+            }
+            // Start a new batch (keeping the capacity)
+            p_addWritten(_buffer.size());
+            _buffer.clear();
+            return true;
+          }
+          /**
+           * @brief Writes the batch periodically.
+           * 
+           */
+          void _writerLoop()
+          {
+            std::unique_lock<std::mutex> lock(p_ChannelMutex);
+            while(!_stop)
+            {
+              // Wait until the next timed write is due
+              _writerCondition.wait_until(lock, _lastWrite + std::chrono::milliseconds(_policy.batchIntervalMs), [this] { return _stop || _intervalElapsed(); });
+              if(_stop) return;
+              // Write the batch
+              _writeBuffer();
+            }
+          }
     };
 }
 
 // Creates a static object from the log
 static drLog::Log& drlog = drLog::Log::getInstance();
 
+// Posts stripped at compile time (their arguments are not even evaluated under DRLOG_MIN_LEVEL) ----
+  // A custom post: DRLOG_MSG("sender", drLog::MsgLevel::MSG_L_LOW, drLog::MsgType::LOG_MSG) << "message";
+  // (a one-shot for instead of an if-else, so an else after the post can't bind to it and -Wdangling-else stays quiet;
+  // its condition is a compile time constant and a stripped level gives a NullPost, so nothing of the post is compiled in)
+  #define DRLOG_MSG(sender, level, type) DRLOG_MSG_ONCE_(sender, level, type, DRLOG_CONCAT_(drlogPost_, __COUNTER__))
+  #define DRLOG_MSG_ONCE_(sender, level, type, once) \
+    for(bool once = true; std::bool_constant<drLog::levelCompiled(level)>::value && once; once = false) drlog.msg<level>(sender, type)
+  #define DRLOG_CONCAT_(first, second) DRLOG_CONCAT_IMPL_(first, second)
+  #define DRLOG_CONCAT_IMPL_(first, second) first##second
+  // The posts of the types: DRLOG_DEBUG("sender") << "message";
+  #define DRLOG_DEBUG(sender) DRLOG_MSG(sender, drLog::MsgLevel::MSG_L_DEBUG, drLog::MsgType::LOG_DEBUG)
+  #define DRLOG_INFO(sender) DRLOG_MSG(sender, drLog::MsgLevel::MSG_L_MEDIUM, drLog::MsgType::LOG_INFO)
+  #define DRLOG_WARNING(sender) DRLOG_MSG(sender, drLog::MsgLevel::MSG_L_MEDIUM, drLog::MsgType::LOG_WARNING)
+  #define DRLOG_ERROR(sender) DRLOG_MSG(sender, drLog::MsgLevel::MSG_L_HIGH, drLog::MsgType::LOG_ERROR)
+
 #endif
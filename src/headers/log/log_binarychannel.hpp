@@ -0,0 +1,667 @@
+#ifndef _LOG_BINARYCHANNEL_HPP_
+#define _LOG_BINARYCHANNEL_HPP_
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "log.hpp"
+#include "../general/datetime.hpp"
+
+namespace drLog
+{
+  /**
+   * @brief A channel which writes compact binary records and leaves the formatting to a decoder.
+   * @details The senders and the formats are written into the file only once (when they are first used),
+   * later the records refer to them by their IDs. A record holds the IDs, the level, the type,
+   * the timestamp in nanoseconds and the raw bytes of the arguments. The formats use '{}' placeholders.
+   * The records coming through the Log are stored with the built-in "{}" format and the message as its argument.
+   * Hot paths can bypass the Log and the text formatting completely:
+   * 
+   *   static const uint32_t sender = channel->registerSender("worker");
+   *   static const uint32_t format = channel->registerFormat("Request {} served in {} us");
+   *   channel->post(sender, format, MsgLevel::MSG_L_MEDIUM, MsgType::LOG_INFO, requestId, latency);
+   * 
+   * The file can be converted into the text layout of the FileChannel with BinaryDecoder (or the logdecode tool).
+   * File layout: "DRLOGBIN" + uint32 version (native byte order), then tagged entries (see BinaryTag).
+   * The IDs, lengths and integers are LEB128 varints (the signed ones zigzag encoded), the timestamps
+   * are stored as the difference from the previous record of the session.
+   * 
+   */
+  class BinaryChannel
+    :
+      public drLog::LogChannel
+  {
+    public:
+      // Constants ----
+        static constexpr char       MAGIC[8]              = { 'D', 'R', 'L', 'O', 'G', 'B', 'I', 'N' };     // Magic of the file.
+        static constexpr uint32_t   VERSION               = 1;                                              // Version of the file layout.
+
+      // Enumerators ----
+        /**
+         * @brief Tags of the entries in the file.
+         * 
+         */
+        enum class BinaryTag : uint8_t
+        {
+          TAG_SESSION = 0,        // length + DTFormat (the IDs and the timestamps restart after it)
+          TAG_FORMAT = 1,         // ID + length + format
+          TAG_SENDER = 2,         // ID + length + name
+          TAG_RECORD = 3,         // sender ID + format ID + uint8 level + uint8 type + signed nanoseconds since the previous record + uint8 argument count + arguments
+        };
+        /**
+         * @brief Types of the arguments in a record.
+         * 
+         */
+        enum class ArgType : uint8_t
+        {
+          ARG_INT = 0,            // signed varint
+          ARG_UINT = 1,           // varint
+          ARG_DOUBLE = 2,         // double (8 bytes)
+          ARG_BOOL = 3,           // uint8
+          ARG_CHAR = 4,           // char
+          ARG_STRING = 5,         // length + bytes
+        };
+
+      // Construction ----
+        /**
+         * @brief Constructs a new BinaryChannel object.
+         * 
+         * @param filePath Path of the binary log file (the records are appended to it).
+         * @param logLevel Level of the logging.
+         * @param DTFormat DateTime format the decoder will use.
+         * @param bufferSize Size of the buffer, the records are written into the file when it is full.
+         */
+        BinaryChannel(const std::string& filePath, const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S", size_t bufferSize = 64 * 1024)
+          :
+            drLog::LogChannel(logLevel, DTFormat),
+            _bufferSize(bufferSize)
+        {
+          // Open the file
+          _fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+          if(_fd < 0)
+          {
+            p_addFailure();
+            std::cerr << "!!!--> Failed to open binary log file: " << filePath << " <--!!!\n";
+            return;
+          }
+          // Reserve the buffer
+          _buffer.reserve(_bufferSize + 1024);
+          // A new file gets the file header
+          struct stat fileStat;
+          if(::fstat(_fd, &fileStat) == 0 && fileStat.st_size == 0)
+          {
+            _buffer.append(MAGIC, sizeof(MAGIC));
+            _put<uint32_t>(VERSION);
+          }
+          // Start a new session (the IDs of the earlier sessions are not valid anymore)
+          _put(BinaryTag::TAG_SESSION);
+          _putString(DTFormat);
+          // The built-in format of the text records
+          _formats.push_back("{}");
+          _putDefinition(BinaryTag::TAG_FORMAT, 0, "{}");
+        }
+        /**
+         * @brief Destroys the BinaryChannel object.
+         * 
+         */
+        ~BinaryChannel()
+        {
+          // Write out the buffer and close the file
+          _flushBuffer();
+          if(_fd >= 0) ::close(_fd);
+        }
+
+      // Functions ----
+        /**
+         * @brief Registers a sender (once, typically into a static variable).
+         * 
+         * @param name Name of the sender.
+         * @return uint32_t ID of the sender.
+         */
+        uint32_t registerSender(std::string_view name)
+        {
+          std::lock_guard<std::mutex> lock(p_ChannelMutex);
+          return _senderId(name);
+        }
+        /**
+         * @brief Registers a format (once, typically into a static variable).
+         * 
+         * @param format The format, every '{}' is replaced by the next argument.
+         * @return uint32_t ID of the format.
+         */
+        uint32_t registerFormat(std::string_view format)
+        {
+          std::lock_guard<std::mutex> lock(p_ChannelMutex);
+          // Store it
+          uint32_t id = uint32_t(_formats.size());
+          _formats.emplace_back(format);
+          // Write its definition
+          _putDefinition(BinaryTag::TAG_FORMAT, id, format);
+          return id;
+        }
+        /**
+         * @brief Writes a record with deferred formatting (the arguments are stored in binary form).
+         * 
+         * @tparam Args Types of the arguments (arithmetic types, characters, bools and strings).
+         * @param senderId ID of the sender (from registerSender()).
+         * @param formatId ID of the format (from registerFormat()).
+         * @param level Level of the message.
+         * @param type Type of the message.
+         * @param args The arguments.
+         * @return true Write has successed.
+         * @return false Write has failed.
+         */
+        template<typename... Args>
+        bool post(uint32_t senderId, uint32_t formatId, MsgLevel level, MsgType type, const Args&... args)
+        {
+          // The argument count is stored in one byte
+          static_assert(sizeof...(Args) <= 255, "BinaryChannel supports at most 255 arguments in a post!");
+          // Filtered by the level, or written under the lock (and counted in the metrics like the other posts)
+          return p_countedWrite(level, [&]
+            {
+              // The header of the record
+              _putRecordHeader(senderId, formatId, level, type, std::chrono::system_clock::now(), uint8_t(sizeof...(Args)));
+              // The arguments
+              (_putArg(args), ...);
+              // Write it out if the buffer is full
+              if(_buffer.size() >= _bufferSize) return _flushBuffer();
+              return true;
+            });
+        }
+        /**
+         * @brief Writes the log.
+         * 
+         * @param record The record we want to write.
+         * @return true Write has successed.
+         * @return false Write has failed.
+         */
+        bool write(const LogRecord& record) override
+        {
+          // If the message level is higher or the same we do the post
+          if(int(record.level)>=int(logLevel()))
+          {
+            // The record with the built-in format and the message as argument
+            _putRecordHeader(_recordSenderId(record), 0, record.level, record.type, record.dateTime, 1);
+            bool location = sourceLocation() && record.location.line() != 0;
+            if(record.fields.empty() && !location) _putArg(record.message);
+            // The structured fields (and the source location) go after the message as text
+            else
+            {
+              _fieldsText.assign(record.message);
+              appendFieldsText(_fieldsText, record.fields);
+              if(location) appendLocationText(_fieldsText, record.location);
+              _putArg(std::string_view(_fieldsText));
+            }
+            // Write it out if the buffer is full
+            if(_buffer.size() >= _bufferSize) return _flushBuffer();
+          }
+          return true;
+        }
+        /**
+         * @brief Writes the buffer into the file.
+         * 
+         */
+        void flush() override
+        {
+          _flushBuffer();
+        }
+
+    private:
+      // Variables ----
+        int                                             _fd                 = -1;           // Descriptor of the file.
+        size_t                                          _bufferSize;                        // Size of the buffer.
+        std::string                                     _buffer;                            // The records waiting for the write.
+        std::string                                     _fieldsText;                        // The message with the structured fields.
+        std::vector<uint32_t>                           _internedSenders;                   // Our sender IDs of the interned senders of the Log (index = its id, 0 = unknown yet).
+        std::vector<std::string>                        _formats;                           // The registered formats.
+        std::map<std::string, uint32_t, std::less<>>    _senders;                           // The registered senders.
+        int64_t                                         _lastTime           = 0;            // Timestamp of the previous record (nanoseconds).
+
+      // Functions ----
+        /**
+         * @brief Gets the ID of a sender (and registers it if it is new).
+         * 
+         * @param name Name of the sender.
+         * @return uint32_t ID of the sender.
+         */
+        uint32_t _senderId(std::string_view name)
+        {
+          // Check if we know it
+          auto it = _senders.find(name);
+          if(it != _senders.end()) return it->second;
+          // Register it
+          uint32_t id = uint32_t(_senders.size());
+          _senders.emplace(std::string(name), id);
+          _putDefinition(BinaryTag::TAG_SENDER, id, name);
+          return id;
+        }
+        /**
+         * @brief Gets the ID of the sender of a record (interned senders without looking up their name).
+         * 
+         * @param record The record.
+         * @return uint32_t ID of the sender.
+         */
+        uint32_t _recordSenderId(const LogRecord& record)
+        {
+          // Not interned
+          if(record.senderId == 0) return _senderId(record.className);
+          // Cached
+          if(record.senderId < _internedSenders.size() && _internedSenders[record.senderId] != 0) return _internedSenders[record.senderId] - 1;
+          // Cache it
+          if(record.senderId >= _internedSenders.size()) _internedSenders.resize(record.senderId + 1, 0);
+          uint32_t id = _senderId(record.className);
+          _internedSenders[record.senderId] = id + 1;
+          return id;
+        }
+        /**
+         * @brief Puts a value in its raw form into the buffer.
+         * 
+         * @tparam T Type of the value.
+         * @param value The value.
+         */
+        template<typename T>
+        void _put(const T& value)
+        {
+          _buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        /**
+         * @brief Encodes an unsigned varint.
+         * 
+         * @param out Where we write (it needs 10 bytes).
+         * @param value The value.
+         * @return char* The end of the written bytes.
+         */
+        static char* _encodeVarint(char* out, uint64_t value)
+        {
+          // 7 bits at a time, the high bit means there are more
+          while(value >= 0x80)
+          {
+            *out++ = char((value & 0x7F) | 0x80);
+            value >>= 7;
+          }
+          *out++ = char(value);
+          return out;
+        }
+        /**
+         * @brief Puts an unsigned varint into the buffer.
+         * 
+         * @param value The value.
+         */
+        void _putVarint(uint64_t value)
+        {
+          char bytes[10];
+          _buffer.append(bytes, _encodeVarint(bytes, value));
+        }
+        /**
+         * @brief Puts a string with its length into the buffer.
+         * 
+         * @param text The string.
+         */
+        void _putString(std::string_view text)
+        {
+          _putVarint(text.size());
+          _buffer.append(text);
+        }
+        /**
+         * @brief Puts a sender or format definition into the buffer.
+         * 
+         * @param tag Tag of the definition.
+         * @param id The ID.
+         * @param text The name or the format.
+         */
+        void _putDefinition(BinaryTag tag, uint32_t id, std::string_view text)
+        {
+          _put(tag);
+          _putVarint(id);
+          _putString(text);
+        }
+        /**
+         * @brief Puts the header of a record into the buffer.
+         * 
+         * @param senderId ID of the sender.
+         * @param formatId ID of the format.
+         * @param level Level of the message.
+         * @param type Type of the message.
+         * @param dateTime Time of the message.
+         * @param argCount Number of the arguments.
+         */
+        void _putRecordHeader(uint32_t senderId, uint32_t formatId, MsgLevel level, MsgType type, const std::chrono::system_clock::time_point& dateTime, uint8_t argCount)
+        {
+          // The difference from the previous record (zigzag encoded, the threads can come in a bit out of order)
+          int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(dateTime.time_since_epoch()).count();
+          int64_t delta = nanoseconds - _lastTime;
+          _lastTime = nanoseconds;
+          // Put the header together and append it at once
+          char header[1 + 5 + 5 + 1 + 1 + 10 + 1];
+          char* end = header;
+          *end++ = char(BinaryTag::TAG_RECORD);
+          end = _encodeVarint(end, senderId);
+          end = _encodeVarint(end, formatId);
+          *end++ = char(level);
+          *end++ = char(type);
+          end = _encodeVarint(end, (uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+          *end++ = char(argCount);
+          _buffer.append(header, end);
+        }
+        /**
+         * @brief Puts an argument with its type into the buffer.
+         * 
+         * @tparam T Type of the argument.
+         * @param value The argument.
+         */
+        template<typename T>
+        void _putArg(const T& value)
+        {
+          if constexpr (std::is_same_v<T, bool>) { _put(ArgType::ARG_BOOL); _put<uint8_t>(value ? 1 : 0); }
+          else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) { _put(ArgType::ARG_CHAR); _put<char>(char(value)); }
+          else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) { _put(ArgType::ARG_INT); _putVarint((uint64_t(int64_t(value)) << 1) ^ uint64_t(int64_t(value) >> 63)); }
+          else if constexpr (std::is_integral_v<T>) { _put(ArgType::ARG_UINT); _putVarint(value); }
+          else if constexpr (std::is_floating_point_v<T>) { _put(ArgType::ARG_DOUBLE); _put<double>(value); }
+          else if constexpr (std::is_convertible_v<const T&, std::string_view>) { _put(ArgType::ARG_STRING); _putString(std::string_view(value)); }
+          else static_assert(std::is_convertible_v<const T&, std::string_view>, "BinaryChannel supports only arithmetic and string arguments!");
+        }
+        /**
+         * @brief Writes the buffer into the file.
+         * 
+         * @return true Write has successed.
+         * @return false Write has failed.
+         */
+        bool _flushBuffer()
+        {
+          // Nothing to do
+          if(_buffer.empty()) return true;
+          if(_fd < 0)
+          {
+            p_addFailure();
+            _buffer.clear();
+            return false;
+          }
+          // Write everything (write can be partial)
+          size_t written = 0;
+          while(written < _buffer.size())
+          {
+            ssize_t result = ::write(_fd, _buffer.data() + written, _buffer.size() - written);
+            if(result < 0)
+            {
+              if(errno == EINTR) continue;
+              p_addFailure();
+              std::cerr << "!!!--> Failed to write binary log file! <--!!!\n";
+              _buffer.clear();
+              return false;
+            }
+            written += size_t(result);
+          }
+          // The buffer is free again
+          p_addWritten(written);
+          _buffer.clear();
+          return true;
+        }
+  };
+
+  /**
+   * @brief Reads the files of the BinaryChannel and formats them into the text layout of the FileChannel.
+   * 
+   */
+  class BinaryDecoder
+  {
+    public:
+      // Construction ----
+        /**
+         * @brief Constructs a new BinaryDecoder object.
+         * 
+         * @param data Content of the binary log file.
+         * @param DTFormat DateTime format to use instead of the one stored in the file (empty = use the stored one).
+         */
+        BinaryDecoder(std::string_view data, const std::string& DTFormat = "")
+          :
+            _data(data),
+            _forcedDTFormat(DTFormat)
+        {
+          // Check the header
+          if(_data.size() < sizeof(BinaryChannel::MAGIC) + sizeof(uint32_t) || _data.substr(0, sizeof(BinaryChannel::MAGIC)) != std::string_view(BinaryChannel::MAGIC, sizeof(BinaryChannel::MAGIC)))
+          {
+            _error = "Not a binary log file!";
+            return;
+          }
+          // Check the version of the layout
+          _pos = sizeof(BinaryChannel::MAGIC);
+          uint32_t version = 0;
+          _get(version);
+          if(version != BinaryChannel::VERSION) _error = "Unknown version of the binary log file (" + std::to_string(version) + ")!";
+        }
+
+      // Functions ----
+        /**
+         * @brief Decodes the next record into a text line (without the line break).
+         * 
+         * @param line The decoded line.
+         * @return true We have a line.
+         * @return false End of the file (or an error, see error()).
+         */
+        bool next(std::string& line)
+        {
+          // Going through the entries until we find a record
+          while(_error.empty() && _pos < _data.size())
+          {
+            // Get the tag
+            uint8_t tag;
+            if(!_get(tag)) break;
+            switch(BinaryChannel::BinaryTag(tag))
+            {
+              case BinaryChannel::BinaryTag::TAG_SESSION:
+              {
+                // New session: reset the IDs and set the datetime format
+                std::string_view format;
+                if(!_getString(format)) break;
+                _formats.clear();
+                _senders.clear();
+                _lastTime = 0;
+                _timeStamp.dateTimeFormat(_forcedDTFormat.empty() ? std::string(format) : _forcedDTFormat);
+                break;
+              }
+              case BinaryChannel::BinaryTag::TAG_FORMAT:
+              case BinaryChannel::BinaryTag::TAG_SENDER:
+              {
+                // Store the definition
+                uint64_t id;
+                std::string_view text;
+                if(!_getVarint(id) || !_getString(text)) break;
+                std::vector<std::string>& list = BinaryChannel::BinaryTag(tag) == BinaryChannel::BinaryTag::TAG_FORMAT ? _formats : _senders;
+                if(list.size() <= id) list.resize(id + 1);
+                list[id] = std::string(text);
+                break;
+              }
+              case BinaryChannel::BinaryTag::TAG_RECORD:
+                return _decodeRecord(line);
+              default:
+                _error = "Unknown entry in the file!";
+                break;
+            }
+          }
+          return false;
+        }
+
+      // Getters ----
+        /**
+         * @brief Gets the error of the decoding.
+         * 
+         * @return const std::string& The error (empty if everything was fine).
+         */
+        const std::string& error() const
+        {
+          return _error;
+        }
+
+    private:
+      // Variables ----
+        std::string_view                        _data;                      // Content of the file.
+        size_t                                  _pos              = 0;      // Current position.
+        std::string                             _forcedDTFormat;            // DateTime format given by the user.
+        std::string                             _error;                     // Error of the decoding.
+        std::vector<std::string>                _formats;                   // The defined formats.
+        std::vector<std::string>                _senders;                   // The defined senders.
+        int64_t                                 _lastTime         = 0;      // Timestamp of the previous record (nanoseconds).
+        Utils::DateTime::TimeStampFormatter     _timeStamp;                 // Formatter of the timestamps.
+
+      // Functions ----
+        /**
+         * @brief Reads a raw value.
+         * 
+         * @tparam T Type of the value.
+         * @param value The value.
+         * @return true We could read it.
+         * @return false The file is truncated.
+         */
+        template<typename T>
+        bool _get(T& value)
+        {
+          if(_pos + sizeof(T) > _data.size()) { _error = "Truncated file!"; return false; }
+          std::memcpy(&value, _data.data() + _pos, sizeof(T));
+          _pos += sizeof(T);
+          return true;
+        }
+        /**
+         * @brief Reads an unsigned varint.
+         * 
+         * @param value The value.
+         * @return true We could read it.
+         * @return false The file is truncated.
+         */
+        bool _getVarint(uint64_t& value)
+        {
+          value = 0;
+          // 7 bits at a time, the high bit means there are more
+          for(int shift = 0; shift < 64; shift += 7)
+          {
+            uint8_t byte;
+            if(!_get(byte)) return false;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) return true;
+          }
+          _error = "Broken varint!";
+          return false;
+        }
+        /**
+         * @brief Reads a zigzag encoded signed varint.
+         * 
+         * @param value The value.
+         * @return true We could read it.
+         * @return false The file is truncated.
+         */
+        bool _getSignedVarint(int64_t& value)
+        {
+          uint64_t raw;
+          if(!_getVarint(raw)) return false;
+          value = int64_t(raw >> 1) ^ -int64_t(raw & 1);
+          return true;
+        }
+        /**
+         * @brief Reads a string with its length.
+         * 
+         * @param text The string (views the data).
+         * @return true We could read it.
+         * @return false The file is truncated.
+         */
+        bool _getString(std::string_view& text)
+        {
+          uint64_t length;
+          if(!_getVarint(length)) return false;
+          if(_pos + length > _data.size()) { _error = "Truncated file!"; return false; }
+          text = _data.substr(_pos, length);
+          _pos += length;
+          return true;
+        }
+        /**
+         * @brief Reads an argument and formats it into a string (like LogPost formats it).
+         * 
+         * @param out The string we append to.
+         * @return true We could read it.
+         * @return false The file is broken.
+         */
+        bool _decodeArg(std::string& out)
+        {
+          // Get the type
+          uint8_t type;
+          if(!_get(type)) return false;
+          char number[64];
+          switch(BinaryChannel::ArgType(type))
+          {
+            case BinaryChannel::ArgType::ARG_INT: { int64_t value; if(!_getSignedVarint(value)) return false; out.append(number, std::to_chars(number, number + sizeof(number), value).ptr); return true; }
+            case BinaryChannel::ArgType::ARG_UINT: { uint64_t value; if(!_getVarint(value)) return false; out.append(number, std::to_chars(number, number + sizeof(number), value).ptr); return true; }
+            case BinaryChannel::ArgType::ARG_DOUBLE: { double value; if(!_get(value)) return false; out.append(number, std::to_chars(number, number + sizeof(number), value, std::chars_format::general, 6).ptr); return true; }
+            case BinaryChannel::ArgType::ARG_BOOL: { uint8_t value; if(!_get(value)) return false; out.push_back(value ? '1' : '0'); return true; }
+            case BinaryChannel::ArgType::ARG_CHAR: { char value; if(!_get(value)) return false; out.push_back(value); return true; }
+            case BinaryChannel::ArgType::ARG_STRING: { std::string_view value; if(!_getString(value)) return false; out.append(value); return true; }
+            default: _error = "Unknown argument type!"; return false;
+          }
+        }
+        /**
+         * @brief Decodes a record into a text line.
+         * 
+         * @param line The decoded line.
+         * @return true We could decode it.
+         * @return false The file is broken.
+         */
+        bool _decodeRecord(std::string& line)
+        {
+          // Read the header
+          uint64_t senderId, formatId;
+          uint8_t level, type, argCount;
+          int64_t delta;
+          if(!_getVarint(senderId) || !_getVarint(formatId) || !_get(level) || !_get(type) || !_getSignedVarint(delta) || !_get(argCount)) return false;
+          // The timestamp is relative to the previous record
+          _lastTime += delta;
+          int64_t nanoseconds = _lastTime;
+          // Check the IDs
+          if(senderId >= _senders.size() || formatId >= _formats.size()) { _error = "Undefined sender or format!"; return false; }
+          // The prefix: [timestamp] - [TYP] <sender> =>
+          std::chrono::system_clock::time_point dateTime { std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds)) };
+          line.clear();
+          line += '[';
+          line += _timeStamp.format(dateTime);
+          line += "] - [";
+          line += getMsgTypeStr(MsgType(type));
+          line += "] <";
+          line += _senders[senderId];
+          line += "> => ";
+          // The message: the format with the arguments in its placeholders
+          std::string_view format = _formats[formatId];
+          uint8_t used = 0;
+          size_t start = 0;
+          while(true)
+          {
+            size_t placeholder = format.find("{}", start);
+            // No more placeholders (or arguments)
+            if(placeholder == std::string_view::npos || used == argCount)
+            {
+              line += format.substr(start);
+              break;
+            }
+            // The text before and the argument
+            line += format.substr(start, placeholder - start);
+            if(!_decodeArg(line)) return false;
+            ++used;
+            start = placeholder + 2;
+          }
+          // Extra arguments are put at the end
+          for(; used < argCount; ++used)
+          {
+            line += ' ';
+            if(!_decodeArg(line)) return false;
+          }
+          return true;
+        }
+  };
+}
+
+#endif
@@ -3,14 +3,91 @@
 
 #include <iostream>
 #include <filesystem>
-#include <fstream>
+#include <string_view>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <condition_variable>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "log.hpp"
-#include "../general/string.hpp"
 #include "../general/datetime.hpp"
+#include "../general/sizes.hpp"
 
 namespace drLog
 {
+  // Enumerators ----
+    /**
+     * @brief When the FileChannel asks the kernel to put the written data onto the disk.
+     * 
+     */
+    enum class FsyncPolicy : unsigned int
+    {
+      FSYNC_NEVER = 0,
+      FSYNC_ON_FLUSH = 1,
+      FSYNC_ON_ERROR = 2,
+    };
+    /**
+     * @brief How long a log file of the FileChannel covers.
+     * 
+     */
+    enum class FileRotation : unsigned int
+    {
+      ROTATE_DAILY = 0,
+      ROTATE_HOURLY = 1,
+    };
+    /**
+     * @brief How the FileChannel puts the records into the file.
+     * 
+     */
+    enum class FileWriteMode : unsigned int
+    {
+      WRITE_DIRECT = 0,
+      WRITE_MMAP = 1,
+    };
+
+  // Structures ----
+    /**
+     * @brief How and when the FileChannel writes its records into the file.
+     * @details The default writes every record immediately (with one writev call per record).
+     * For the buffered mode set flushBytes: the records are collected in the buffer and written in batches.
+     * Setting flushBytes to bufferSize leaves the writes to the full buffer and the explicit flush() calls.
+     * In WRITE_MMAP mode the file is extended by preallocated segments of segmentSize bytes which are mapped
+     * into the memory, and the records are copied straight into the mapping (no system call per record).
+     * The buffer settings don't apply there: a flush is an asynchronous msync (a synchronous one if fsync asks for it).
+     * Until the file is closed, its end is filled with zeros (up to the end of the segment); after a crash
+     * the channel cuts them (and the partial last line) off when it opens the file again.
+     * 
+     */
+    struct FileFlushPolicy
+    {
+      FileWriteMode             writeMode         = FileWriteMode::WRITE_DIRECT;  // How we put the records into the file.
+      size_t                    segmentSize       = 4 * MB;                     // Size of the mapped segments (WRITE_MMAP).
+      size_t                    bufferSize        = 64 * KB;                    // Size of the user-space buffer.
+      size_t                    flushBytes        = 0;                          // Write the buffer when it has at least this many bytes (0 = every record).
+      size_t                    flushIntervalMs   = 0;                          // Write the buffer at least this often (0 = no timed writes).
+      bool                      flushOnError      = true;                       // Write the buffer immediately when an error message comes.
+      FsyncPolicy               fsync             = FsyncPolicy::FSYNC_NEVER;   // When we call fdatasync after writing.
+    };
+    /**
+     * @brief When the FileChannel starts a new log file.
+     * @details Daily files are logPath/YYYY/MM/DD.log, hourly files are logPath/YYYY/MM/DD/HH.log.
+     * With maxFileSize the files of a period are split: DD.log, DD.1.log, DD.2.log...
+     * 
+     */
+    struct FileRotationPolicy
+    {
+      FileRotation              period            = FileRotation::ROTATE_DAILY; // Period of the files.
+      size_t                    maxFileSize       = 0;                          // Start a new file above this size (0 = no limit).
+    };
+
+  // Classes ----
   class FileChannel
     :
       public drLog::LogChannel
@@ -23,12 +100,16 @@ namespace drLog
          * @param logPath Path of the logging files.
          * @param logLevel Level of the logging.
          * @param DTFormat DateTime format of the logging.
+         * @param flushPolicy When the channel writes its buffer and syncs the file.
+         * @param rotationPolicy When the channel starts a new file.
          */
-        FileChannel(const std::string& logPath, const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S")
+        FileChannel(const std::string& logPath, const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S", const FileFlushPolicy& flushPolicy = FileFlushPolicy(), const FileRotationPolicy& rotationPolicy = FileRotationPolicy())
           :
             drLog::LogChannel(logLevel, DTFormat),
             _logPath(logPath),
-            _filePath(logPath)
+            _filePath(logPath),
+            _flushPolicy(flushPolicy),
+            _rotationPolicy(rotationPolicy)
         {
           // Check if path is a directory and reducing it if it is
           if(!std::filesystem::is_directory(_logPath)) _filePath = _filePath.parent_path();
@@ -38,10 +119,16 @@ namespace drLog
             // Trying to create the path
             if (!std::filesystem::create_directories(_logPath))
             {
+              p_addFailure();
               std::cerr << "!!!--> Failed to create log directory structure: " << _logPath << " <--!!!\n";
               std::runtime_error("Failed to create log directory structure!");
             }
           }
+          // Reserve the buffer
+          _buffer.reserve(_flushPolicy.bufferSize);
+          _lastFlush = std::chrono::steady_clock::now();
+          // Timed writes need a thread (so the buffer doesn't wait for the next record)
+          if(_flushPolicy.flushIntervalMs > 0) _flusher = std::thread(&FileChannel::_flusherLoop, this);
         }
         /**
          * @brief Destroys the FileChannel object.
@@ -49,83 +136,531 @@ namespace drLog
          */
         ~FileChannel()
         {
-          // If file is open, we close it
-          if(_file.is_open()) _file.close();
+          // Stop the flusher thread
+          if(_flusher.joinable())
+          {
+            {
+              std::lock_guard<std::mutex> lock(p_ChannelMutex);
+              _stop = true;
+            }
+            _flusherCondition.notify_all();
+            _flusher.join();
+          }
+          // If file is open, we close it (after writing out the buffer)
+          _closeFile();
         }
 
       // Functions ----
         /**
          * @brief Writes the log.
          * 
-         * @param className Name of the sender class.
-         * @param message Message we want to write
-         * @param level Level of the message.
-         * @param type Type of the message.
-         * @param dateTime The datetime when we write it on the channel.
+         * @param record The record we want to write.
          * @return true Write has successed.
          * @return false Write has failed.
          */
-        bool write(std::string className, std::string message, MsgLevel level, MsgType type, const std::time_t& dateTime) override
+        bool write(const LogRecord& record) override
         {
           // If the message level is higher or the same we do the post
-          if(int(level)>=int(p_LogLevel))
+          if(int(record.level)>=int(logLevel()))
+          {
+            // Start a new file if the record is out of the period of the current one (a simple comparison in most cases)
+            std::time_t dateTime = std::chrono::system_clock::to_time_t(record.dateTime);
+            if(_fd < 0 || dateTime >= _periodEnd || dateTime < _periodStart)
+            {
+              if(!_startPeriod(dateTime)) return false;
+            }
+            // At the end we will write the log
+            std::string type = getMsgTypeStr(record.type);
+            // The structured fields (and the source location) as text
+            _fieldsText.clear();
+            appendFieldsText(_fieldsText, record.fields);
+            if(sourceLocation()) appendLocationText(_fieldsText, record.location);
+            std::string_view pieces[] = {
+              "[", p_TimeStamp.format(record.dateTime), "] - ",                                 // TimeStamp
+              "[", type, "] ",                                                                  // Type
+              "<", record.className, "> => ",                                                   // Sender
+              record.message, _fieldsText, "\n"                                                 // Message and fields
+            };
+            // An error message can make us write (and sync) immediately
+            bool error = record.type == MsgType::LOG_ERROR;
+            // Size of the line
+            size_t size = 0;
+            for(const std::string_view& piece : pieces) size += piece.size();
+            // Start a new file if this one would be too big (the next one can be a partially filled one from an earlier run)
+            while(_rotationPolicy.maxFileSize > 0 && _fileSize > 0 && _fileSize + size > _rotationPolicy.maxFileSize)
+            {
+              ++_fileIndex;
+              if(!_openCurrentFile()) return false;
+            }
+            _fileSize += size;
+            // In mmap mode we copy it into the mapping
+            if(_flushPolicy.writeMode == FileWriteMode::WRITE_MMAP) return _appendMapped(pieces, std::size(pieces), size, error);
+            // If the line doesn't fit into the buffer (or we don't buffer), we write it together with the buffer
+            if(_flushPolicy.flushBytes == 0 || _buffer.size() + size > _flushPolicy.bufferSize) return _writeOut(pieces, std::size(pieces), error);
+            // Otherwise we collect it
+            for(const std::string_view& piece : pieces) _buffer.append(piece);
+            // Check if we have to write the buffer
+            if(_buffer.size() >= _flushPolicy.flushBytes || (error && _flushPolicy.flushOnError) || _intervalElapsed()) return _flushBuffer(error);
+          }
+          return true;
+        }
+        /**
+         * @brief Writes the buffer into the log file.
+         * 
+         */
+        void flush() override
+        {
+          _flushBuffer(false);
+        }
+
+    private:
+      // Variables ----
+        std::filesystem::path                   _logPath;                 // Path for the log files.
+        std::filesystem::path                   _filePath;                // Filepath of the last log file.
+        int                                     _fd             = -1;     // Descriptor of the file.
+        FileFlushPolicy                         _flushPolicy;             // When we write the buffer.
+        FileRotationPolicy                      _rotationPolicy;          // When we start a new file.
+        std::time_t                             _periodStart    = 0;      // Start of the period of the current file.
+        std::time_t                             _periodEnd      = 0;      // End of the period of the current file (the next rollover).
+        tm                                      _periodTime     = {};     // Local time of the period start (for the file names).
+        size_t                                  _fileIndex      = 0;      // Index of the file within the period (size based rotation).
+        size_t                                  _fileSize       = 0;      // Size of the current file (with the buffered bytes).
+        size_t                                  _fileEnd        = 0;      // End of the written data in the file (WRITE_MMAP).
+        size_t                                  _mapOffset      = 0;      // Offset of the mapped segment in the file (WRITE_MMAP).
+        size_t                                  _mapSize        = 0;      // Size of the mapped segment (WRITE_MMAP).
+        char*                                   _mapBase        = nullptr; // The mapped segment (WRITE_MMAP).
+        std::string                             _buffer;                  // The lines waiting for the write.
+        std::string                             _fieldsText;              // The structured fields (and the source location) of the current record as text.
+        std::chrono::steady_clock::time_point   _lastFlush;               // Time of the last write.
+        std::thread                             _flusher;                 // Thread of the timed writes.
+        std::condition_variable                 _flusherCondition;        // Wakes up the flusher thread when we stop.
+        bool                                    _stop           = false;  // Stop sign for the flusher thread.
+
+      // Functions ----
+        /**
+         * @brief Opens a log file for appending (and creates it if it does not exist).
+         * 
+         * @param filePath Path of the file.
+         * @param writeMode How we will write the file.
+         * @return int The descriptor of the file (-1 on error).
+         */
+        static int _openFile(const std::filesystem::path& filePath, FileWriteMode writeMode)
+        {
+          // The mapping needs read access and explicit positions
+          if(writeMode == FileWriteMode::WRITE_MMAP) return ::open(filePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+          return ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        }
+        /**
+         * @brief Calculates the period of a time and opens its file.
+         * 
+         * @param dateTime The time.
+         * @return true The file is open.
+         * @return false We couldn't open the file.
+         */
+        bool _startPeriod(std::time_t dateTime)
+        {
+          // Convert time to local time and cut it to the start of the period
+          tm localTime;
+          localtime_r(&dateTime, &localTime);
+          localTime.tm_sec = 0;
+          localTime.tm_min = 0;
+          if(_rotationPolicy.period == FileRotation::ROTATE_DAILY) localTime.tm_hour = 0;
+          localTime.tm_isdst = -1;
+          _periodStart = mktime(&localTime);
+          _periodTime = localTime;
+          // The next period (mktime normalizes the overflow and handles the DST changes)
+          tm nextTime = localTime;
+          if(_rotationPolicy.period == FileRotation::ROTATE_DAILY) nextTime.tm_mday += 1;
+          else nextTime.tm_hour += 1;
+          nextTime.tm_isdst = -1;
+          _periodEnd = mktime(&nextTime);
+          // Open the first file of the period
+          _fileIndex = 0;
+          return _openCurrentFile();
+        }
+        /**
+         * @brief Opens the current file of the period (skipping the files that are already full).
+         * 
+         * @return true The file is open.
+         * @return false We couldn't open the file.
+         */
+        bool _openCurrentFile()
+        {
+          // Write out the buffer into the old file and close it
+          _closeFile();
+          // Searching for the file we can continue
+          while(true)
+          {
+            // Build the path: YYYY/MM/DD[.N].log or YYYY/MM/DD/HH[.N].log
+            char name[64];
+            char index[24] = "";
+            if(_fileIndex > 0) std::snprintf(index, sizeof(index), ".%zu", _fileIndex);
+            if(_rotationPolicy.period == FileRotation::ROTATE_DAILY) std::snprintf(name, sizeof(name), "%04d/%02d/%02d%s.log", _periodTime.tm_year + 1900, _periodTime.tm_mon + 1, _periodTime.tm_mday, index);
+            else std::snprintf(name, sizeof(name), "%04d/%02d/%02d/%02d%s.log", _periodTime.tm_year + 1900, _periodTime.tm_mon + 1, _periodTime.tm_mday, _periodTime.tm_hour, index);
+            _filePath = _logPath / name;
+            // Check the size of the existing file
+            struct stat fileStat;
+            _fileSize = ::stat(_filePath.c_str(), &fileStat) == 0 ? size_t(fileStat.st_size) : 0;
+            if(_rotationPolicy.maxFileSize == 0 || _fileSize < _rotationPolicy.maxFileSize) break;
+            // It is full, trying the next one
+            ++_fileIndex;
+          }
+          // Create the new filepath
+          std::error_code errorCode;
+          if (!std::filesystem::exists(_filePath.parent_path(), errorCode))
+          {
+            if (!std::filesystem::create_directories(_filePath.parent_path(), errorCode))
+            {
+              p_addFailure();
+              std::cerr << "!!!--> Failed to create today's log directory structure: " << _filePath.parent_path() << " <--!!!\n";
+              return false;
+            }
+          }
+          // Trying to create file (and create if it does not exists)
+          _fd = _openFile(_filePath, _flushPolicy.writeMode);
+          // Check if file is okay (created)
+          if(_fd < 0)
+          {
+            // Nope
+            p_addFailure();
+            std::cerr << "!!!--> Failed to create today's log file: " << _filePath << " <--!!!\n";
+            return false;
+          }
+          // In mmap mode we recover the file (if it was left open by a crash) and map its end
+          if(_flushPolicy.writeMode == FileWriteMode::WRITE_MMAP)
+          {
+            _fileEnd = _recoverFile();
+            _fileSize = _fileEnd;
+            return _mapSegment();
+          }
+          return true;
+        }
+        /**
+         * @brief Closes the current file.
+         * 
+         */
+        void _closeFile()
+        {
+          // Nothing to do
+          if(_fd < 0) return;
+          // Direct mode: write out the buffer
+          if(_flushPolicy.writeMode == FileWriteMode::WRITE_DIRECT) _flushBuffer(false);
+          // Mmap mode: release the segment and cut the preallocated zeros
+          else
+          {
+            _unmapSegment();
+            if(::ftruncate(_fd, off_t(_fileEnd)) != 0)
+            {
+              p_addFailure();
+              std::cerr << "!!!--> Failed to truncate the log file: " << _filePath << " <--!!!\n";
+            }
+          }
+          ::close(_fd);
+          _fd = -1;
+        }
+        /**
+         * @brief Finds the real end of a file written in mmap mode and cuts the rest.
+         * @details If the process crashed, the file ends with the zeros of the preallocated segment,
+         * and maybe with a partially copied line. We keep everything until the last full line before the zeros.
+         * 
+         * @return size_t The real length of the file.
+         */
+        size_t _recoverFile()
+        {
+          // Get the size
+          struct stat fileStat;
+          if(::fstat(_fd, &fileStat) != 0 || fileStat.st_size == 0) return 0;
+          size_t size = size_t(fileStat.st_size);
+          // A properly closed file doesn't end with zero
+          char last = 0;
+          if(::pread(_fd, &last, 1, off_t(size - 1)) != 1 || last != 0) return size;
+          // Searching backwards for the last line break (skipping the zeros and the partial line)
+          char chunk[4096];
+          size_t end = size;
+          while(end > 0)
           {
-            // Create today's log path
-            std::vector<std::string> todayDate = Utils::String::split(Utils::DateTime::getTimeTInStr(dateTime, "%Y/%m/%d"), '/');
-            std::filesystem::path newFilePath = _logPath / todayDate[0] / todayDate[1] / (todayDate[2] + ".log");
-            // Check the filepath
-            if(_filePath!=newFilePath)
+            size_t start = end > sizeof(chunk) ? end - sizeof(chunk) : 0;
+            ssize_t length = ::pread(_fd, chunk, end - start, off_t(start));
+            if(length <= 0) break;
+            for(ssize_t i = length - 1; i >= 0; --i)
             {
-              // Set the new filePath
-              _filePath = newFilePath;
-              // Create the new filepath
-              if (!std::filesystem::exists(_filePath.parent_path()))
+              if(chunk[i] == '\n')
               {
-                if (!std::filesystem::create_directories(_filePath.parent_path()))
+                end = start + size_t(i) + 1;
+                if(::ftruncate(_fd, off_t(end)) != 0)
                 {
-                  std::cerr << "!!!--> Failed to create today's log directory structure: " << _filePath.parent_path() << " <--!!!\n";
-                  std::runtime_error("Failed to create today's log directory structure!");
-                  return false;
+                  p_addFailure();
+                  std::cerr << "!!!--> Failed to truncate the log file: " << _filePath << " <--!!!\n";
                 }
+                return end;
+              }
+            }
+            end = start;
+          }
+          // Not a single full line
+          if(::ftruncate(_fd, 0) != 0)
+          {
+            p_addFailure();
+            std::cerr << "!!!--> Failed to truncate the log file: " << _filePath << " <--!!!\n";
+          }
+          return 0;
+        }
+        /**
+         * @brief Preallocates and maps the segment which starts at the page of the current end of the file.
+         * @details If the file can't be extended for the whole segment (a copy into the mapping past the end of the file
+         * would kill the process with SIGBUS) or the mapping fails, the channel falls back to WRITE_DIRECT.
+         * 
+         * @return true The segment is mapped (or the channel writes directly from now on).
+         * @return false We couldn't fall back either.
+         */
+        bool _mapSegment()
+        {
+          // The mapping has to start at a page boundary
+          size_t pageSize = size_t(::sysconf(_SC_PAGESIZE));
+          _mapOffset = _fileEnd / pageSize * pageSize;
+          size_t segmentSize = (_flushPolicy.segmentSize + pageSize - 1) / pageSize * pageSize;
+          // Preallocate the segment (falling back to a sparse extension only if the filesystem can't preallocate)
+          if(::fallocate(_fd, 0, off_t(_mapOffset), off_t(segmentSize)) != 0)
+          {
+            if(errno == ENOSPC || errno == EDQUOT)
+            {
+              p_addFailure();
+              std::cerr << "!!!--> No space to preallocate the log file: " << _filePath << " <--!!!\n";
+              return _fallBackToDirect();
+            }
+            struct stat fileStat;
+            if(::fstat(_fd, &fileStat) != 0)
+            {
+              p_addFailure();
+              std::cerr << "!!!--> Failed to get the size of the log file: " << _filePath << " <--!!!\n";
+              return _fallBackToDirect();
+            }
+            if(size_t(fileStat.st_size) < _mapOffset + segmentSize)
+            {
+              // The extension has to succeed and really reach the end of the segment
+              if(::ftruncate(_fd, off_t(_mapOffset + segmentSize)) != 0 || ::fstat(_fd, &fileStat) != 0 || size_t(fileStat.st_size) < _mapOffset + segmentSize)
+              {
+                p_addFailure();
+                std::cerr << "!!!--> Failed to extend the log file: " << _filePath << " <--!!!\n";
+                return _fallBackToDirect();
               }
-              // Close file if needed
-              if(_file.is_open()) _file.close();
-              // Trying to create file (and create if it does not exists)
-              _file.open(_filePath, std::ios::out | std::ios::app);
-              // Check if file is okay (created)
-              if(!_file)
+            }
+          }
+          // Map it
+          void* base = ::mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, off_t(_mapOffset));
+          if(base == MAP_FAILED)
+          {
+            p_addFailure();
+            std::cerr << "!!!--> Failed to map the log file: " << _filePath << " <--!!!\n";
+            _mapBase = nullptr;
+            return _fallBackToDirect();
+          }
+          _mapBase = static_cast<char*>(base);
+          _mapSize = segmentSize;
+          return true;
+        }
+        /**
+         * @brief Switches the channel to WRITE_DIRECT: cuts the preallocated part of the file and appends at its end from now on.
+         * 
+         * @return true The file can be written directly.
+         * @return false We couldn't set it up.
+         */
+        bool _fallBackToDirect()
+        {
+          _unmapSegment();
+          _flushPolicy.writeMode = FileWriteMode::WRITE_DIRECT;
+          _fileSize = _fileEnd;
+          // The file could be extended before the failure
+          if(::ftruncate(_fd, off_t(_fileEnd)) != 0)
+          {
+            p_addFailure();
+            std::cerr << "!!!--> Failed to truncate the log file: " << _filePath << " <--!!!\n";
+          }
+          // The descriptor was opened for mmap, so it has to append now
+          int flags = ::fcntl(_fd, F_GETFL);
+          if(flags < 0 || ::fcntl(_fd, F_SETFL, flags | O_APPEND) != 0)
+          {
+            p_addFailure();
+            std::cerr << "!!!--> Failed to switch the log file to direct writes: " << _filePath << " <--!!!\n";
+            return false;
+          }
+          std::cerr << "!!!--> The log file is written directly instead of the mapping from now on: " << _filePath << " <--!!!\n";
+          return true;
+        }
+        /**
+         * @brief Starts the asynchronous write of the current segment and unmaps it.
+         * 
+         */
+        void _unmapSegment()
+        {
+          if(!_mapBase) return;
+          ::msync(_mapBase, _mapSize, MS_ASYNC);
+          ::munmap(_mapBase, _mapSize);
+          _mapBase = nullptr;
+        }
+        /**
+         * @brief Copies a line into the mapped segment.
+         * 
+         * @param pieces The pieces of the line.
+         * @param count Number of the pieces.
+         * @param size Size of the line.
+         * @param error Is it an error message.
+         * @return true Write has successed.
+         * @return false Write has failed.
+         */
+        bool _appendMapped(const std::string_view* pieces, size_t count, size_t size, bool error)
+        {
+          // The line doesn't fit into the segment: we go on with the next one
+          if(!_mapBase || _fileEnd - _mapOffset + size > _mapSize)
+          {
+            _unmapSegment();
+            if(!_mapSegment()) return false;
+            // We couldn't map the segment, the line goes directly (the fallback has reset the size to the written data)
+            if(_flushPolicy.writeMode == FileWriteMode::WRITE_DIRECT)
+            {
+              _fileSize += size;
+              return _writeOut(pieces, count, error);
+            }
+          }
+          // A line bigger than a segment is written directly
+          if(_fileEnd - _mapOffset + size > _mapSize)
+          {
+            for(size_t i = 0; i < count; ++i)
+            {
+              if(::pwrite(_fd, pieces[i].data(), pieces[i].size(), off_t(_fileEnd)) != ssize_t(pieces[i].size()))
               {
-                // Nope
-                std::cerr << "!!!--> Failed to create today's log file: " << _filePath << " <--!!!\n";
-                std::runtime_error("Failed to create today's log file!");
+                p_addFailure();
+                std::cerr << "!!!--> Failed to write the log file: " << _filePath << " <--!!!\n";
                 return false;
               }
+              _fileEnd += pieces[i].size();
             }
-            // Trying to open file
-            if(!_file.is_open()) _file.open(_filePath,std::ios::out | std::ios::app);
-            // Check if we could open it
-            if(!_file.is_open())
+            p_addWritten(size);
+            _unmapSegment();
+            return _mapSegment();
+          }
+          // Copy the pieces into the memory
+          char* target = _mapBase + (_fileEnd - _mapOffset);
+          for(size_t i = 0; i < count; ++i)
+          {
+            std::memcpy(target, pieces[i].data(), pieces[i].size());
+            target += pieces[i].size();
+          }
+          _fileEnd += size;
+          p_addWritten(size);
+          // Sync if we need
+          if(error && _flushPolicy.flushOnError) return _flushBuffer(error);
+          return true;
+        }
+        /**
+         * @brief Checks if the timed write is due.
+         * 
+         * @return true We have to write the buffer.
+         * @return false We can wait.
+         */
+        bool _intervalElapsed() const
+        {
+          if(_flushPolicy.flushIntervalMs == 0) return false;
+          return std::chrono::steady_clock::now() - _lastFlush >= std::chrono::milliseconds(_flushPolicy.flushIntervalMs);
+        }
+        /**
+         * @brief Writes the buffer into the file.
+         * 
+         * @param error Did an error message make us write.
+         * @return true Write has successed.
+         * @return false Write has failed.
+         */
+        bool _flushBuffer(bool error)
+        {
+          // In mmap mode we only start the write of the mapped pages (or wait for it if we need to sync)
+          if(_flushPolicy.writeMode == FileWriteMode::WRITE_MMAP)
+          {
+            _lastFlush = std::chrono::steady_clock::now();
+            if(!_mapBase) return true;
+            bool sync = _flushPolicy.fsync == FsyncPolicy::FSYNC_ON_FLUSH || (error && _flushPolicy.fsync == FsyncPolicy::FSYNC_ON_ERROR);
+            return ::msync(_mapBase, _mapSize, sync ? MS_SYNC : MS_ASYNC) == 0;
+          }
+          return _writeOut(nullptr, 0, error);
+        }
+        /**
+         * @brief Writes the buffer and some extra pieces into the file with one writev call.
+         * 
+         * @param pieces The pieces we write after the buffer.
+         * @param count Number of the pieces.
+         * @param error Did an error message make us write.
+         * @return true Write has successed.
+         * @return false Write has failed.
+         */
+        bool _writeOut(const std::string_view* pieces, size_t count, bool error)
+        {
+          // Collect the parts
+          iovec parts[16];
+          int partCount = 0;
+          if(!_buffer.empty()) parts[partCount++] = { _buffer.data(), _buffer.size() };
+          for(size_t i = 0; i < count && partCount < 16; ++i)
+          {
+            if(!pieces[i].empty()) parts[partCount++] = { const_cast<char*>(pieces[i].data()), pieces[i].size() };
+          }
+          // Nothing to write
+          _lastFlush = std::chrono::steady_clock::now();
+          if(partCount == 0) return true;
+          // We don't have a file
+          if(_fd < 0)
+          {
+            p_addFailure();
+            _buffer.clear();
+            return false;
+          }
+          // Write everything (writev can be partial)
+          iovec* part = parts;
+          while(partCount > 0)
+          {
+            ssize_t written = ::writev(_fd, part, partCount);
+            if(written < 0)
             {
-              // Nope
-              std::cerr << "!!!--> Failed to open today's log file: " << _filePath << " <--!!!\n";
-              std::runtime_error("Failed to open today's log file!");
+              if(errno == EINTR) continue;
+              p_addFailure();
+              std::cerr << "!!!--> Failed to write the log file: " << _filePath << " <--!!!\n";
+              _buffer.clear();
               return false;
             }
-            // At the end we will write the log
-            _file <<
-              "[" << Utils::DateTime::getTimeTInStr(dateTime, p_DTFormat) + "] - " <<     // TimeStamp
-              "[" << getMsgTypeStr(type) << "] " <<                                       // Type
-              "<" << className << "> => " <<                                              // Sender
-              message << "\n";                                                            // Message
+            // Skip the parts we have written
+            p_addWritten(size_t(written));
+            while(partCount > 0 && size_t(written) >= part->iov_len)
+            {
+              written -= part->iov_len;
+              ++part;
+              --partCount;
+            }
+            // Step in the partially written part
+            if(partCount > 0)
+            {
+              part->iov_base = static_cast<char*>(part->iov_base) + written;
+              part->iov_len -= written;
+            }
           }
+          // The buffer is free again
+          _buffer.clear();
+          // Sync if we need
+          if(_flushPolicy.fsync == FsyncPolicy::FSYNC_ON_FLUSH || (error && _flushPolicy.fsync == FsyncPolicy::FSYNC_ON_ERROR)) ::fdatasync(_fd);
           return true;
         }
-
-    private:
-      // Variables ----
-        std::filesystem::path       _logPath;             // Path for the log files.
-        std::filesystem::path       _filePath;            // Filepath of the last log file.
-        std::fstream                _file;                // A stream for the file.
+        /**
+         * @brief The loop of the flusher thread (writes the buffer after flushIntervalMs).
+         * 
+         */
+        void _flusherLoop()
+        {
+          std::unique_lock<std::mutex> lock(p_ChannelMutex);
+          while(!_stop)
+          {
+            // Wait until the next timed write is due
+            _flusherCondition.wait_until(lock, _lastFlush + std::chrono::milliseconds(_flushPolicy.flushIntervalMs), [this] { return _stop || _intervalElapsed(); });
+            if(_stop) return;
+            // Write the buffer
+            _flushBuffer(false);
+          }
+        }
   };
 }
 
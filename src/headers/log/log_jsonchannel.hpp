@@ -3,15 +3,32 @@
 
 #include <iostream>
 #include <functional>
+#include <string_view>
+#include <thread>
+#include <condition_variable>
 
 #include "log.hpp"
 #include "../general/string.hpp"
 #include "../general/datetime.hpp"
-
-#include "../vendor/nlohmann/json.hpp"
+#include "../general/sizes.hpp"
 
 namespace drLog
 {
+  // Structures ----
+    /**
+     * @brief When the JsonChannel delivers its collected records.
+     * @details The records are collected as NDJSON (every record is a json object closed by a '\n')
+     * and the whole batch is handed to the callback at once.
+     * 
+     */
+    struct JsonBatchPolicy
+    {
+      size_t                    batchBytes        = 64 * KB;                    // Deliver the batch when it has at least this many bytes.
+      size_t                    batchIntervalMs   = 0;                          // Deliver the batch at least this often (0 = no timed delivery).
+      bool                      deliverOnError    = true;                       // Deliver the batch immediately when an error message comes.
+    };
+
+  // Classes ----
   class JsonChannel
     :
       public drLog::LogChannel
@@ -19,56 +36,205 @@ namespace drLog
     public:
       // Construction ----
         /**
-         * @brief Constructs a new JsonChannel object.
+         * @brief Constructs a new JsonChannel object (which calls the callback for every record).
          * 
          * @param event Event callback function for the output.
          * @param logLevel Level of the logging.
          * @param DTFormat DateTime format of the logging.
          */
-        JsonChannel(std::function<void(const std::string)> event, const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S")
+        JsonChannel(std::function<void(const std::string&)> event, const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S")
           :
             drLog::LogChannel(logLevel, DTFormat),
             _event(event)
         {}
+        /**
+         * @brief Constructs a new JsonChannel object (which collects the records and calls the callback with batches).
+         * 
+         * @param batchEvent Event callback function for the batches (NDJSON: one record per line).
+         * @param batchPolicy When the batches are delivered.
+         * @param logLevel Level of the logging.
+         * @param DTFormat DateTime format of the logging.
+         */
+        JsonChannel(std::function<void(std::string_view)> batchEvent, const JsonBatchPolicy& batchPolicy, const LogLevel& logLevel = LogLevel::LOG_LEVEL_NORMAL, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S")
+          :
+            drLog::LogChannel(logLevel, DTFormat),
+            _batchEvent(batchEvent),
+            _batchPolicy(batchPolicy)
+        {
+          // Reserve the batch (a record can go a bit over the threshold)
+          _line.reserve(_batchPolicy.batchBytes + 1 * KB);
+          _lastDelivery = std::chrono::steady_clock::now();
+          // Timed delivery needs a thread (so the batch doesn't wait for the next record)
+          if(_batchPolicy.batchIntervalMs > 0) _deliverer = std::thread(&JsonChannel::_delivererLoop, this);
+        }
         /**
          * @brief Destroys the JsonChannel object.
          * 
          */
-        ~JsonChannel() = default;
+        ~JsonChannel()
+        {
+          // Stop the deliverer thread
+          if(_deliverer.joinable())
+          {
+            {
+              std::lock_guard<std::mutex> lock(p_ChannelMutex);
+              _stop = true;
+            }
+            _delivererCondition.notify_all();
+            _deliverer.join();
+          }
+          // Deliver the rest
+          _deliverBatch();
+        }
 
       // Functions ----
         /**
          * @brief Writes the log.
          * 
-         * @param className Name of the sender class.
-         * @param message Message we want to write
-         * @param level Level of the message.
-         * @param type Type of the message.
-         * @param dateTime The datetime when we write it on the channel.
+         * @param record The record we want to write.
          * @return true Write has successed.
          * @return false Write has failed.
          */
-        bool write(std::string className, std::string message, MsgLevel level, MsgType type, const std::time_t& dateTime) override
+        bool write(const LogRecord& record) override
         {
           // If the message level is higher or the same we do the post
-          if(int(level)>=int(p_LogLevel))
+          if(int(record.level)>=int(logLevel()))
           {
-            // Create json
-            nlohmann::json entry;
-            entry["timestamp"] = Utils::DateTime::getTimeTInStr(dateTime, p_DTFormat);
-            entry["type"] = getMsgTypeStr(type);
-            entry["sender"] = className;
-            entry["message"] = message;
+            // Without batching the line is built from the start
+            if(!_batchEvent) _line.clear();
+            // Create json (the keys in the same order as nlohmann::json puts them, the fields after them)
+            _line.append("{\"message\":\"");
+            Utils::String::appendJsonEscaped(_line, record.message);
+            _line.append("\",\"sender\":\"");
+            Utils::String::appendJsonEscaped(_line, record.className);
+            _line.append("\",\"timestamp\":\"");
+            Utils::String::appendJsonEscaped(_line, p_TimeStamp.format(record.dateTime));
+            _line.append("\",\"type\":\"");
+            _line.append(getMsgTypeStr(record.type));
+            _line.push_back('"');
+            // The source location
+            if(sourceLocation() && record.location.line() != 0)
+            {
+              char number[16];
+              _line.append(",\"file\":\"");
+              Utils::String::appendJsonEscaped(_line, record.location.file_name());
+              _line.append("\",\"line\":");
+              _line.append(number, std::to_chars(number, number + sizeof(number), record.location.line()).ptr);
+            }
+            // The structured fields as native members
+            for(const LogField& field : record.fields)
+            {
+              _line.append(",\"");
+              Utils::String::appendJsonEscaped(_line, field.key);
+              _line.append("\":");
+              switch(field.type)
+              {
+                case FieldType::FIELD_STRING:
+                  _line.push_back('"');
+                  Utils::String::appendJsonEscaped(_line, field.stringValue);
+                  _line.push_back('"');
+                  break;
+                case FieldType::FIELD_DOUBLE:
+                {
+                  // JSON doesn't know NaN and infinity (nlohmann::json writes null too)
+                  if(!std::isfinite(field.doubleValue))
+                  {
+                    _line.append("null");
+                    break;
+                  }
+                  // Whole numbers keep the ".0", so they stay floating points for the parsers
+                  size_t start = _line.size();
+                  field.appendValue(_line);
+                  if(_line.find_first_of(".e", start) == std::string::npos) _line.append(".0");
+                  break;
+                }
+                default:
+                  field.appendValue(_line);
+                  break;
+              }
+            }
+            _line.push_back('}');
             // Write msg
-            _event(entry.dump());
+            if(!_batchEvent)
+            {
+              p_addWritten(_line.size());
+              _event(_line);
+              return true;
+            }
+            // Or close the line in the batch, and deliver it if it is due
+            _line.push_back('\n');
+            ++_batchCount;
+            bool error = record.type == MsgType::LOG_ERROR && _batchPolicy.deliverOnError;
+            if(error || _line.size() >= _batchPolicy.batchBytes || _intervalElapsed()) _deliverBatch();
           }
           return true;
         }
+        /**
+         * @brief Delivers the collected records.
+         * 
+         */
+        void flush() override
+        {
+          _deliverBatch();
+        }
 
     private:
       // Variables ----
-        std::function<void(const std::string)>    _event;           // A function we use when message comes in.
+        std::function<void(const std::string&)>   _event;           // A function we use when message comes in.
+        std::function<void(std::string_view)>     _batchEvent;      // A function we use when a batch is ready (batching mode).
+        JsonBatchPolicy                           _batchPolicy;     // When we deliver the batches.
+        std::string                               _line;            // The serialized record or the batch (reused, so it keeps its capacity).
+        size_t                                    _batchCount = 0;  // Number of the records in the batch.
+        std::chrono::steady_clock::time_point     _lastDelivery;    // Time of the last delivery.
+        std::thread                               _deliverer;       // Thread of the timed deliveries.
+        std::condition_variable                   _delivererCondition; // Wakes up the deliverer thread when we stop.
+        bool                                      _stop = false;    // Stop sign for the deliverer thread.
+
+      // Functions ----
+        /**
+         * @brief Checks if the timed delivery is due.
+         * 
+         * @return true We have to deliver the batch.
+         * @return false We can wait.
+         */
+        bool _intervalElapsed() const
+        {
+          if(_batchPolicy.batchIntervalMs == 0) return false;
+          return std::chrono::steady_clock::now() - _lastDelivery >= std::chrono::milliseconds(_batchPolicy.batchIntervalMs);
+        }
+        /**
+         * @brief Hands the batch to the callback and starts a new one.
+         * 
+         */
+        void _deliverBatch()
+        {
+          _lastDelivery = std::chrono::steady_clock::now();
+          // Nothing to deliver
+          if(!_batchEvent || _batchCount == 0) return;
+          // Deliver it
+          p_addWritten(_line.size());
+          _batchEvent(std::string_view(_line));
+          // Start a new one (keeping the capacity)
+          _line.clear();
+          _batchCount = 0;
+        }
+        /**
+         * @brief Delivers the batch periodically.
+         * 
+         */
+        void _delivererLoop()
+        {
+          std::unique_lock<std::mutex> lock(p_ChannelMutex);
+          while(!_stop)
+          {
+            // Wait until the next timed delivery is due
+            _delivererCondition.wait_until(lock, _lastDelivery + std::chrono::milliseconds(_batchPolicy.batchIntervalMs), [this] { return _stop || _intervalElapsed(); });
+            if(_stop) return;
+            // Deliver the batch
+            _deliverBatch();
+          }
+        }
   };
 }
 
-#endif
\ No newline at end of file
+#endif
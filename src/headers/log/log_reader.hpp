@@ -0,0 +1,1013 @@
+#ifndef _LOG_READER_HPP_
+#define _LOG_READER_HPP_
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log.hpp"
+#include "../general/datetime.hpp"
+
+namespace drLog
+{
+  // Constants ----
+    // Number of the message types (the slots of the type counters)
+    static constexpr size_t MSG_TYPE_COUNT = 5;
+
+  // Structures ----
+    /**
+     * @brief A record read back from the files of a FileChannel.
+     * @details The views point into the mapped file, they are valid until the reader is closed.
+     * 
+     */
+    struct LogEntry
+    {
+      std::string_view          text;                                           // The whole record (without the last line break).
+      std::string_view          timestamp;                                      // The timestamp text.
+      std::string_view          sender;                                         // Name of the sender.
+      std::string_view          message;                                        // The message (with the fields, and the next lines of a multi-line message).
+      MsgType                   type              = MsgType::LOG_MSG;           // Type of the message.
+      std::chrono::system_clock::time_point   dateTime;                         // The parsed timestamp.
+      size_t                    offset            = 0;                          // Position of the record in the file.
+    };
+    /**
+     * @brief A query of the records.
+     * 
+     */
+    struct LogQuery
+    {
+      std::chrono::system_clock::time_point   from = std::chrono::system_clock::time_point::min();  // Start of the time range (inclusive).
+      std::chrono::system_clock::time_point   to = std::chrono::system_clock::time_point::max();    // End of the time range (exclusive).
+      std::vector<MsgType>      types;                                          // The wanted types (empty = every type).
+      std::string               sender;                                         // The wanted sender (empty = every sender).
+      std::string               contains;                                       // The message has to contain this text (empty = every message).
+    };
+    /**
+     * @brief Number of the records by their types.
+     * 
+     */
+    struct LogCounts
+    {
+      size_t                    total             = 0;                          // Number of every record.
+      std::array<size_t, MSG_TYPE_COUNT>      byType = {};                      // Number of the records by type (see getMsgTypeSlot()).
+    };
+    /**
+     * @brief A file of a FileChannel tree.
+     * 
+     */
+    struct LogFileInfo
+    {
+      std::filesystem::path     path;                                           // Path of the file.
+      std::chrono::system_clock::time_point   periodStart;                      // Start of the period of the file (by its path).
+      std::chrono::system_clock::time_point   periodEnd;                        // End of the period of the file.
+      unsigned int              index             = 0;                          // Index of the file in its period (DD.N.log).
+    };
+    /**
+     * @brief How the sparse index of a file is built and stored.
+     * 
+     */
+    struct LogIndexPolicy
+    {
+      size_t                    stride            = 1024;                       // Records per index block.
+      bool                      storeIndex        = true;                       // Store the index next to the file (<file>.idx) and reuse it.
+    };
+
+  // Functions ----
+    /**
+     * @brief Gives back the counter slot of a message type (0 = MSG, 1 = INF, 2 = WAR, 3 = ERR, 4 = DBG).
+     * 
+     * @param msgType The type.
+     * @return size_t The slot.
+     */
+    static size_t getMsgTypeSlot(const MsgType& msgType)
+    {
+      switch(msgType)
+      {
+        case MsgType::LOG_INFO:
+          return 1;
+        case MsgType::LOG_WARNING:
+          return 2;
+        case MsgType::LOG_ERROR:
+          return 3;
+        case MsgType::LOG_DEBUG:
+          return 4;
+        default:
+        case MsgType::LOG_MSG:
+          return 0;
+      }
+    }
+    /**
+     * @brief Gives back the MsgType of its name (the reverse of getMsgTypeStr()).
+     * 
+     * @param name Name of the type (e.g. "ERR").
+     * @param msgType The type.
+     * @return true The name is known.
+     * @return false Unknown name.
+     */
+    static bool getMsgTypeFromStr(std::string_view name, MsgType& msgType)
+    {
+      static constexpr std::pair<std::string_view, MsgType> names[] = {
+        { "MSG", MsgType::LOG_MSG }, { "INF", MsgType::LOG_INFO }, { "WAR", MsgType::LOG_WARNING }, { "ERR", MsgType::LOG_ERROR }, { "DBG", MsgType::LOG_DEBUG }
+      };
+      for(const auto& [text, type] : names)
+      {
+        if(text != name) continue;
+        msgType = type;
+        return true;
+      }
+      return false;
+    }
+    /**
+     * @brief Parses a time of a query ("%Y-%m-%d %H:%M:%S" or "%Y-%m-%d", local time).
+     * 
+     * @param text The text.
+     * @param timePoint The time point.
+     * @return true The time is parsed.
+     * @return false Wrong time.
+     */
+    static bool parseQueryTime(std::string_view text, std::chrono::system_clock::time_point& timePoint)
+    {
+      Utils::DateTime::TimeStampParser full("%Y-%m-%d %H:%M:%S");
+      Utils::DateTime::TimeStampParser date("%Y-%m-%d");
+      return full.parse(text, timePoint) || date.parse(text, timePoint);
+    }
+    /**
+     * @brief Parses a comma separated list of type names (e.g. "ERR,WAR") for a query.
+     * 
+     * @param list The list.
+     * @param types The types are added to it.
+     * @param unknown The first unknown name (if there is one).
+     * @return true Every name is known.
+     * @return false Unknown name.
+     */
+    static bool parseMsgTypeList(std::string_view list, std::vector<MsgType>& types, std::string_view& unknown)
+    {
+      while(!list.empty())
+      {
+        size_t comma = std::min(list.find(','), list.size());
+        MsgType type;
+        if(!getMsgTypeFromStr(list.substr(0, comma), type))
+        {
+          unknown = list.substr(0, comma);
+          return false;
+        }
+        types.push_back(type);
+        list.remove_prefix(std::min(comma + 1, list.size()));
+      }
+      return true;
+    }
+    /**
+     * @brief Splits a line into the parts of the FileChannel layout: "[timestamp] - [TYP] <sender> => message".
+     * 
+     * @param line The line (without the line break).
+     * @param entry The entry we fill (text, timestamp, type, sender and message).
+     * @return true The line starts a record.
+     * @return false The line is not a record header (e.g. the next line of a multi-line message).
+     */
+    static bool parseLogLine(std::string_view line, LogEntry& entry)
+    {
+      // [timestamp] - [
+      if(line.size() < 2 || line[0] != '[') return false;
+      size_t close = line.find("] - [", 1);
+      if(close == std::string_view::npos) return false;
+      // TYP] <
+      size_t typeStart = close + 5;
+      if(line.size() < typeStart + 6 || line.compare(typeStart + 3, 3, "] <") != 0) return false;
+      if(!getMsgTypeFromStr(line.substr(typeStart, 3), entry.type)) return false;
+      // sender> => message
+      size_t senderStart = typeStart + 6;
+      size_t arrow = line.find("> => ", senderStart);
+      if(arrow == std::string_view::npos) return false;
+      entry.text = line;
+      entry.timestamp = line.substr(1, close - 1);
+      entry.sender = line.substr(senderStart, arrow - senderStart);
+      entry.message = line.substr(arrow + 5);
+      return true;
+    }
+    /**
+     * @brief Finds the end of a line.
+     * 
+     * @param data The content.
+     * @param position Start of the line.
+     * @param end End of the readable part.
+     * @return size_t Position of the line break (or the end).
+     */
+    static size_t findLineEnd(std::string_view data, size_t position, size_t end)
+    {
+      const void* found = std::memchr(data.data() + position, '\n', end - position);
+      return found ? size_t(static_cast<const char*>(found) - data.data()) : end;
+    }
+    /**
+     * @brief Reads the next record of a FileChannel file (the header line and the next lines of a multi-line message).
+     * @details The timestamp is not parsed, entry.dateTime is left as it was.
+     * 
+     * @param data The content of the file.
+     * @param position Position of the record, moved to the next one.
+     * @param end End of the readable part.
+     * @param entry The record.
+     * @return true We have a record.
+     * @return false End of the part.
+     */
+    static bool nextLogRecord(std::string_view data, size_t& position, size_t end, LogEntry& entry)
+    {
+      // Find the header line (skipping the lines which are not records, e.g. written by something else)
+      bool found = false;
+      while(!found && position < end)
+      {
+        size_t lineEnd = findLineEnd(data, position, end);
+        found = parseLogLine(data.substr(position, lineEnd - position), entry);
+        if(found) entry.offset = position;
+        position = lineEnd + 1;
+      }
+      if(!found) return false;
+      // The next lines of the message belong to the record
+      size_t recordEnd = position - 1;
+      LogEntry next;
+      while(position < end)
+      {
+        size_t lineEnd = findLineEnd(data, position, end);
+        if(parseLogLine(data.substr(position, lineEnd - position), next)) break;
+        recordEnd = lineEnd;
+        position = lineEnd + 1;
+      }
+      entry.text = data.substr(entry.offset, recordEnd - entry.offset);
+      entry.message = std::string_view(entry.message.data(), data.data() + recordEnd - entry.message.data());
+      return true;
+    }
+    /**
+     * @brief Finds the first record starting at or after a position (to split a file into chunks at record boundaries).
+     * 
+     * @param data The content of the file.
+     * @param position The position.
+     * @return size_t Start of the record (or the end of the content).
+     */
+    static size_t findLogRecordStart(std::string_view data, size_t position)
+    {
+      // Go to the start of the next line
+      if(position == 0) return 0;
+      position = std::min(findLineEnd(data, position - 1, data.size()) + 1, data.size());
+      // Skip the next lines of a multi-line message
+      LogEntry entry;
+      while(position < data.size())
+      {
+        size_t lineEnd = findLineEnd(data, position, data.size());
+        if(parseLogLine(data.substr(position, lineEnd - position), entry)) break;
+        position = lineEnd + 1;
+      }
+      return std::min(position, data.size());
+    }
+    /**
+     * @brief Gets the period of a file by its path in the tree (YYYY/MM/DD[.N].log or YYYY/MM/DD/HH[.N].log).
+     * 
+     * @param logPath Root of the tree.
+     * @param filePath Path of the file.
+     * @param info The info we fill.
+     * @return true The path is a file of a FileChannel.
+     * @return false Not a log file of the tree.
+     */
+    static bool getLogFileInfo(const std::filesystem::path& logPath, const std::filesystem::path& filePath, LogFileInfo& info)
+    {
+      // The parts of the relative path
+      if(filePath.extension() != ".log") return false;
+      std::vector<std::string> parts;
+      for(const std::filesystem::path& part : filePath.lexically_relative(logPath)) parts.push_back(part.string());
+      if(parts.size() != 3 && parts.size() != 4) return false;
+      // The name of the file: NN.log or NN.I.log
+      std::string name = filePath.stem().string();
+      unsigned int index = 0;
+      size_t dot = name.find('.');
+      if(dot != std::string::npos)
+      {
+        auto [end, error] = std::from_chars(name.data() + dot + 1, name.data() + name.size(), index);
+        if(error != std::errc() || end != name.data() + name.size()) return false;
+        name.resize(dot);
+      }
+      parts.back() = name;
+      // The numbers of the period
+      int numbers[4] = { 0, 1, 1, 0 };
+      for(size_t i = 0; i < parts.size(); ++i)
+      {
+        auto [end, error] = std::from_chars(parts[i].data(), parts[i].data() + parts[i].size(), numbers[i]);
+        if(error != std::errc() || end != parts[i].data() + parts[i].size()) return false;
+      }
+      // Start and end of the period (in local time, like the FileChannel)
+      tm localTime = {};
+      localTime.tm_year = numbers[0] - 1900;
+      localTime.tm_mon = numbers[1] - 1;
+      localTime.tm_mday = numbers[2];
+      localTime.tm_hour = numbers[3];
+      localTime.tm_isdst = -1;
+      tm endTime = localTime;
+      if(parts.size() == 3) ++endTime.tm_mday;
+      else ++endTime.tm_hour;
+      info.path = filePath;
+      info.periodStart = std::chrono::system_clock::from_time_t(mktime(&localTime));
+      info.periodEnd = std::chrono::system_clock::from_time_t(mktime(&endTime));
+      info.index = index;
+      return true;
+    }
+    /**
+     * @brief Lists the files of a FileChannel tree in time order.
+     * 
+     * @param logPath Root of the tree.
+     * @return std::vector<LogFileInfo> The files (ordered by their periods and indexes).
+     */
+    static std::vector<LogFileInfo> findLogFiles(const std::filesystem::path& logPath)
+    {
+      std::vector<LogFileInfo> files;
+      std::error_code errorCode;
+      for(std::filesystem::recursive_directory_iterator it(logPath, errorCode), end; !errorCode && it != end; it.increment(errorCode))
+      {
+        LogFileInfo info;
+        if(it->is_regular_file(errorCode) && getLogFileInfo(logPath, it->path(), info)) files.push_back(std::move(info));
+      }
+      std::sort(files.begin(), files.end(), [](const LogFileInfo& a, const LogFileInfo& b)
+        {
+          return a.periodStart != b.periodStart ? a.periodStart < b.periodStart : a.index < b.index;
+        }
+      );
+      return files;
+    }
+
+  // Classes ----
+  /**
+   * @brief A read-only mapping of a FileChannel file.
+   * @details Only the full lines are visible: the zeros of a preallocated mmap segment
+   * and the last, partially written line of a file which is still written are left out.
+   * 
+   */
+  class LogFileMapping
+  {
+    public:
+      // Construction ----
+        /**
+         * @brief Constructs a new LogFileMapping object.
+         * 
+         */
+        LogFileMapping() = default;
+        /**
+         * @brief Destroys the LogFileMapping object.
+         * 
+         */
+        ~LogFileMapping()
+        {
+          close();
+        }
+        LogFileMapping(const LogFileMapping&) = delete;
+        LogFileMapping& operator=(const LogFileMapping&) = delete;
+
+      // Functions ----
+        /**
+         * @brief Maps a file.
+         * 
+         * @param filePath Path of the file.
+         * @return true The file is mapped.
+         * @return false The file can't be mapped.
+         */
+        bool open(const std::filesystem::path& filePath)
+        {
+          close();
+          // Open the file
+          int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+          struct stat fileStat;
+          if(fd < 0 || ::fstat(fd, &fileStat) != 0)
+          {
+            if(fd >= 0) ::close(fd);
+            std::cerr << "!!!--> Failed to open the log file: " << filePath << " <--!!!\n";
+            return false;
+          }
+          // Map it
+          _mappedSize = size_t(fileStat.st_size);
+          if(_mappedSize > 0)
+          {
+            void* mapping = ::mmap(nullptr, _mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapping == MAP_FAILED)
+            {
+              ::close(fd);
+              _mappedSize = 0;
+              std::cerr << "!!!--> Failed to map the log file: " << filePath << " <--!!!\n";
+              return false;
+            }
+            _mapping = static_cast<const char*>(mapping);
+          }
+          ::close(fd);
+          // Only the full lines are visible
+          _dataSize = _mappedSize;
+          while(_dataSize > 0 && _mapping[_dataSize - 1] == 0) --_dataSize;
+          while(_dataSize > 0 && _mapping[_dataSize - 1] != '\n') --_dataSize;
+          return true;
+        }
+        /**
+         * @brief Unmaps the file.
+         * 
+         */
+        void close()
+        {
+          if(_mapping) ::munmap(const_cast<char*>(_mapping), _mappedSize);
+          _mapping = nullptr;
+          _mappedSize = 0;
+          _dataSize = 0;
+        }
+        /**
+         * @brief Tells the kernel how a part of the file will be read (madvise).
+         * 
+         * @param offset Start of the part.
+         * @param length Length of the part.
+         * @param advice The advice (e.g. MADV_SEQUENTIAL, MADV_DONTNEED).
+         */
+        void advise(size_t offset, size_t length, int advice) const
+        {
+          if(!_mapping || length == 0) return;
+          // The range has to start on a page
+          size_t pageSize = size_t(::sysconf(_SC_PAGESIZE));
+          size_t start = offset / pageSize * pageSize;
+          ::madvise(const_cast<char*>(_mapping) + start, std::min(offset + length, _mappedSize) - start, advice);
+        }
+
+      // Getters ----
+        /**
+         * @brief Gets the full lines of the file.
+         * 
+         * @return std::string_view The content.
+         */
+        std::string_view data() const
+        {
+          return std::string_view(_mapping, _dataSize);
+        }
+
+    private:
+      // Variables ----
+        const char*                             _mapping      = nullptr;  // The mapped file.
+        size_t                                  _mappedSize   = 0;        // Size of the mapping.
+        size_t                                  _dataSize     = 0;        // Bytes of the full lines.
+  };
+  /**
+   * @brief Reads a file of a FileChannel through a read-only mapping and a sparse index.
+   * @details The index has a block for every 'stride' records: its offset, the time range, the number
+   * of the records by type and a 64 bit mask of the sender hashes. The queries skip the blocks which
+   * can't have a matching record, and read only the rest. The index is stored next to the file
+   * (<file>.idx) and reused: if the file has grown since then, only the new records are indexed.
+   * The end of a file which is still written is handled: the zeros of a preallocated mmap segment
+   * and the last, partially written line are left out.
+   * 
+   */
+  class LogFileReader
+  {
+    public:
+      // Construction ----
+        /**
+         * @brief Constructs a new LogFileReader object.
+         * 
+         * @param filePath Path of the log file.
+         * @param DTFormat DateTime format of the FileChannel which wrote the file.
+         * @param indexPolicy How the index is built and stored.
+         */
+        LogFileReader(const std::filesystem::path& filePath, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S", const LogIndexPolicy& indexPolicy = LogIndexPolicy())
+          :
+            _filePath(filePath),
+            _DTFormat(DTFormat),
+            _parser(DTFormat),
+            _indexPolicy(indexPolicy)
+        {
+          if(_indexPolicy.stride == 0) _indexPolicy.stride = 1;
+        }
+        /**
+         * @brief Destroys the LogFileReader object.
+         * 
+         */
+        ~LogFileReader()
+        {
+          close();
+        }
+        LogFileReader(const LogFileReader&) = delete;
+        LogFileReader& operator=(const LogFileReader&) = delete;
+
+      // Functions ----
+        /**
+         * @brief Maps the file and loads (or builds) its index.
+         * 
+         * @return true The file is ready to be queried.
+         * @return false The file can't be read.
+         */
+        bool open()
+        {
+          close();
+          // Map the file (only the full lines are read)
+          if(!_file.open(_filePath)) return false;
+          _mapping = _file.data().data();
+          _dataSize = _file.data().size();
+          // Load the stored index, and index the rest
+          if(!_indexPolicy.storeIndex || !_loadIndex()) _resetIndex();
+          if(_indexedSize < _dataSize)
+          {
+            _extendIndex();
+            if(_indexPolicy.storeIndex) _storeIndex();
+          }
+          return true;
+        }
+        /**
+         * @brief Unmaps the file.
+         * 
+         */
+        void close()
+        {
+          _file.close();
+          _mapping = nullptr;
+          _dataSize = 0;
+        }
+        /**
+         * @brief Calls the callback with every record matching the query (in file order).
+         * 
+         * @tparam F Type of the callback: bool(const LogEntry&), returning false stops the query.
+         * @param query The query.
+         * @param callback The callback.
+         * @return true Every matching record is given.
+         * @return false The callback has stopped the query.
+         */
+        template<typename F>
+        bool query(const LogQuery& query, F&& callback)
+        {
+          Filter filter(query);
+          for(size_t i = 0; i < _blocks.size(); ++i)
+          {
+            // Skip the blocks which can't have a matching record
+            if(!filter.mayMatch(_blocks[i])) continue;
+            // Read the records of the block
+            size_t end = i + 1 < _blocks.size() ? _blocks[i + 1].offset : _indexedSize;
+            LogEntry entry;
+            for(size_t position = _blocks[i].offset; _nextRecord(position, end, entry);)
+            {
+              if(filter.matches(entry) && !callback(entry)) return false;
+            }
+          }
+          return true;
+        }
+        /**
+         * @brief Counts the records matching the query by type.
+         * @details The blocks inside the time range are counted from the index (if the query has no sender and text filter).
+         * 
+         * @param query The query.
+         * @return LogCounts The counts.
+         */
+        LogCounts count(const LogQuery& query)
+        {
+          LogCounts counts;
+          Filter filter(query);
+          for(size_t i = 0; i < _blocks.size(); ++i)
+          {
+            const IndexBlock& block = _blocks[i];
+            if(!filter.mayMatch(block)) continue;
+            // The whole block matches: counting it from the index
+            if(filter.coversBlock(block))
+            {
+              for(size_t slot = 0; slot < MSG_TYPE_COUNT; ++slot)
+              {
+                if(!filter.typeMask[slot]) continue;
+                counts.byType[slot] += block.typeCounts[slot];
+                counts.total += block.typeCounts[slot];
+              }
+              continue;
+            }
+            // Otherwise reading the records
+            size_t end = i + 1 < _blocks.size() ? _blocks[i + 1].offset : _indexedSize;
+            LogEntry entry;
+            for(size_t position = block.offset; _nextRecord(position, end, entry);)
+            {
+              if(!filter.matches(entry)) continue;
+              ++counts.byType[getMsgTypeSlot(entry.type)];
+              ++counts.total;
+            }
+          }
+          return counts;
+        }
+
+      // Getters ----
+        /**
+         * @brief Gets the full lines of the file (valid until the file is closed).
+         * 
+         * @return std::string_view The content.
+         */
+        std::string_view data() const
+        {
+          return _file.data();
+        }
+        /**
+         * @brief Gets the number of the records in the file.
+         * 
+         * @return size_t Number of the records.
+         */
+        size_t records() const
+        {
+          size_t records = 0;
+          for(const IndexBlock& block : _blocks) records += block.records;
+          return records;
+        }
+        /**
+         * @brief Gets the number of the index blocks.
+         * 
+         * @return size_t Number of the blocks.
+         */
+        size_t blocks() const
+        {
+          return _blocks.size();
+        }
+        /**
+         * @brief Gets the number of the records whose timestamp couldn't be parsed (wrong DTFormat).
+         * 
+         * @return size_t Number of the records.
+         */
+        size_t badTimestamps() const
+        {
+          return _badTimestamps;
+        }
+        /**
+         * @brief Gets the path of the file.
+         * 
+         * @return const std::filesystem::path& Path of the file.
+         */
+        const std::filesystem::path& filePath() const
+        {
+          return _filePath;
+        }
+
+    private:
+      // Structures ----
+        /**
+         * @brief A block of the sparse index (stored in the .idx file as it is).
+         * 
+         */
+        struct IndexBlock
+        {
+          uint64_t                offset          = 0;                          // Position of the first record of the block.
+          uint64_t                records         = 0;                          // Number of the records in the block.
+          int64_t                 minTime         = INT64_MAX;                  // Earliest timestamp in the block (nanoseconds since the epoch).
+          int64_t                 maxTime         = INT64_MIN;                  // Latest timestamp in the block (nanoseconds since the epoch).
+          uint32_t                typeCounts[MSG_TYPE_COUNT] = {};              // Number of the records by type.
+          uint32_t                reserved        = 0;                          // Padding.
+          uint64_t                senderMask      = 0;                          // Bits of the sender hashes.
+        };
+        /**
+         * @brief Header of the .idx file.
+         * 
+         */
+        struct IndexHeader
+        {
+          char                    magic[8]        = { 'D', 'R', 'L', 'O', 'G', 'I', 'D', 'X' }; // File identifier.
+          uint32_t                version         = 1;                          // Version of the layout.
+          uint32_t                formatSize      = 0;                          // Length of the DTFormat after the header.
+          uint64_t                stride          = 0;                          // Records per block.
+          uint64_t                indexedSize     = 0;                          // Bytes of the file covered by the index.
+          uint64_t                blockCount      = 0;                          // Number of the blocks after the DTFormat.
+        };
+        /**
+         * @brief A query prepared for the blocks and the records.
+         * 
+         */
+        struct Filter
+        {
+          int64_t                 from;                                         // Start of the time range (nanoseconds since the epoch).
+          int64_t                 to;                                           // End of the time range (nanoseconds since the epoch).
+          bool                    typeMask[MSG_TYPE_COUNT];                     // The wanted type slots.
+          const LogQuery&         query;                                        // The query.
+          uint64_t                senderBit       = 0;                          // Bit of the wanted sender (0 = every sender).
+          /**
+           * @brief Constructs a new Filter object.
+           * 
+           * @param query The query.
+           */
+          Filter(const LogQuery& query)
+            :
+              from(_toNanoseconds(query.from)),
+              to(_toNanoseconds(query.to)),
+              query(query)
+          {
+            for(size_t slot = 0; slot < MSG_TYPE_COUNT; ++slot) typeMask[slot] = query.types.empty();
+            for(const MsgType& type : query.types) typeMask[getMsgTypeSlot(type)] = true;
+            if(!query.sender.empty()) senderBit = _senderBit(query.sender);
+          }
+          /**
+           * @brief Checks if a block can have a matching record.
+           * 
+           * @param block The block.
+           * @return true The block has to be read.
+           * @return false The block can be skipped.
+           */
+          bool mayMatch(const IndexBlock& block) const
+          {
+            if(block.records == 0 || block.maxTime < from || block.minTime >= to) return false;
+            if(senderBit && !(block.senderMask & senderBit)) return false;
+            for(size_t slot = 0; slot < MSG_TYPE_COUNT; ++slot) if(typeMask[slot] && block.typeCounts[slot]) return true;
+            return false;
+          }
+          /**
+           * @brief Checks if every record of the block matches (if the type is right).
+           * 
+           * @param block The block.
+           * @return true The block can be counted from the index.
+           * @return false The records have to be read.
+           */
+          bool coversBlock(const IndexBlock& block) const
+          {
+            return query.sender.empty() && query.contains.empty() && block.minTime >= from && block.maxTime < to;
+          }
+          /**
+           * @brief Checks if a record matches the query.
+           * 
+           * @param entry The record.
+           * @return true It matches.
+           * @return false It doesn't match.
+           */
+          bool matches(const LogEntry& entry) const
+          {
+            int64_t time = _toNanoseconds(entry.dateTime);
+            if(time < from || time >= to || !typeMask[getMsgTypeSlot(entry.type)]) return false;
+            if(!query.sender.empty() && entry.sender != query.sender) return false;
+            return query.contains.empty() || entry.message.find(query.contains) != std::string_view::npos;
+          }
+        };
+
+      // Variables ----
+        std::filesystem::path                   _filePath;                // Path of the log file.
+        std::string                             _DTFormat;                // DateTime format of the timestamps.
+        Utils::DateTime::TimeStampParser        _parser;                  // Parser of the timestamps.
+        LogIndexPolicy                          _indexPolicy;             // How the index is built and stored.
+        LogFileMapping                          _file;                    // The mapped file.
+        const char*                             _mapping      = nullptr;  // The full lines of the file.
+        size_t                                  _dataSize     = 0;        // Bytes of the full lines.
+        std::vector<IndexBlock>                 _blocks;                  // The sparse index.
+        size_t                                  _indexedSize  = 0;        // Bytes covered by the index.
+        size_t                                  _badTimestamps = 0;       // Records with unparsable timestamps.
+
+      // Functions ----
+        /**
+         * @brief Converts a time point into nanoseconds since the epoch (saturated).
+         * 
+         * @param timePoint The time point.
+         * @return int64_t Nanoseconds since the epoch.
+         */
+        static int64_t _toNanoseconds(const std::chrono::system_clock::time_point& timePoint)
+        {
+          // The open ends of the ranges (they would overflow with a coarser clock)
+          if(timePoint == std::chrono::system_clock::time_point::min()) return INT64_MIN;
+          if(timePoint == std::chrono::system_clock::time_point::max()) return INT64_MAX;
+          return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count();
+        }
+        /**
+         * @brief Gets the bit of a sender in the sender masks (FNV-1a hash, so it is the same in every build).
+         * 
+         * @param sender Name of the sender.
+         * @return uint64_t The bit.
+         */
+        static uint64_t _senderBit(std::string_view sender)
+        {
+          uint64_t hash = 14695981039346656037ull;
+          for(char c : sender) hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+          return uint64_t(1) << (hash >> 58);
+        }
+        /**
+         * @brief Reads the next record (the header line and the next lines of a multi-line message).
+         * 
+         * @param position Position of the record, moved to the next one.
+         * @param end End of the readable part.
+         * @param entry The record.
+         * @return true We have a record.
+         * @return false End of the part.
+         */
+        bool _nextRecord(size_t& position, size_t end, LogEntry& entry)
+        {
+          // The parts of the record
+          if(!nextLogRecord(_file.data(), position, end, entry)) return false;
+          // The timestamp
+          if(!_parser.parse(entry.timestamp, entry.dateTime))
+          {
+            entry.dateTime = std::chrono::system_clock::time_point();
+            ++_badTimestamps;
+          }
+          return true;
+        }
+        /**
+         * @brief Clears the index.
+         * 
+         */
+        void _resetIndex()
+        {
+          _blocks.clear();
+          _indexedSize = 0;
+        }
+        /**
+         * @brief Indexes the records after the indexed part.
+         * 
+         */
+        void _extendIndex()
+        {
+          // The last block is rebuilt (it can be partial)
+          size_t position = _indexedSize;
+          if(!_blocks.empty())
+          {
+            position = _blocks.back().offset;
+            _blocks.pop_back();
+          }
+          // Go through the new records
+          _file.advise(position, _dataSize - position, MADV_SEQUENTIAL);
+          LogEntry entry;
+          while(_nextRecord(position, _dataSize, entry))
+          {
+            // Start a new block
+            if(_blocks.empty() || _blocks.back().records >= _indexPolicy.stride)
+            {
+              _blocks.emplace_back();
+              _blocks.back().offset = entry.offset;
+            }
+            // Add the record
+            IndexBlock& block = _blocks.back();
+            int64_t time = _toNanoseconds(entry.dateTime);
+            ++block.records;
+            block.minTime = std::min(block.minTime, time);
+            block.maxTime = std::max(block.maxTime, time);
+            ++block.typeCounts[getMsgTypeSlot(entry.type)];
+            block.senderMask |= _senderBit(entry.sender);
+          }
+          _file.advise(0, _dataSize, MADV_RANDOM);
+          _indexedSize = _dataSize;
+        }
+        /**
+         * @brief Loads the stored index (if it belongs to this file).
+         * 
+         * @return true The index is loaded.
+         * @return false There is no usable index.
+         */
+        bool _loadIndex()
+        {
+          _resetIndex();
+          // Read the header
+          int fd = ::open((_filePath.string() + ".idx").c_str(), O_RDONLY | O_CLOEXEC);
+          if(fd < 0) return false;
+          IndexHeader header, expected;
+          std::string format(_DTFormat.size(), '\0');
+          bool valid = ::read(fd, &header, sizeof(header)) == ssize_t(sizeof(header))
+                    && std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0
+                    && header.version == expected.version && header.stride == _indexPolicy.stride
+                    && header.formatSize == _DTFormat.size() && header.indexedSize <= _dataSize
+                    && ::read(fd, format.data(), format.size()) == ssize_t(format.size()) && format == _DTFormat;
+          // Read the blocks
+          if(valid)
+          {
+            _blocks.resize(header.blockCount);
+            size_t bytes = _blocks.size() * sizeof(IndexBlock);
+            valid = ::read(fd, _blocks.data(), bytes) == ssize_t(bytes);
+          }
+          ::close(fd);
+          // The file has to be the same as it was (the blocks start with records)
+          LogEntry entry;
+          for(const IndexBlock& block : _blocks)
+          {
+            if(!valid) break;
+            valid = block.offset < header.indexedSize && block.offset == _lineStart(block.offset)
+                 && parseLogLine(std::string_view(_mapping + block.offset, findLineEnd(_file.data(), block.offset, _dataSize) - block.offset), entry);
+          }
+          if(!valid)
+          {
+            _resetIndex();
+            return false;
+          }
+          _indexedSize = header.indexedSize;
+          return true;
+        }
+        /**
+         * @brief Finds the start of the line of a position.
+         * 
+         * @param position The position.
+         * @return size_t Start of the line.
+         */
+        size_t _lineStart(size_t position) const
+        {
+          while(position > 0 && _mapping[position - 1] != '\n') --position;
+          return position;
+        }
+        /**
+         * @brief Stores the index next to the file (written into a temporary file and renamed, so readers never see a partial one).
+         * 
+         */
+        void _storeIndex()
+        {
+          // The content
+          IndexHeader header;
+          header.formatSize = uint32_t(_DTFormat.size());
+          header.stride = _indexPolicy.stride;
+          header.indexedSize = _indexedSize;
+          header.blockCount = _blocks.size();
+          std::string content(reinterpret_cast<const char*>(&header), sizeof(header));
+          content.append(_DTFormat);
+          content.append(reinterpret_cast<const char*>(_blocks.data()), _blocks.size() * sizeof(IndexBlock));
+          // Write it (a read-only tree just doesn't get an index)
+          std::string path = _filePath.string() + ".idx";
+          std::string temporary = path + ".tmp" + std::to_string(::getpid());
+          int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+          if(fd < 0) return;
+          bool written = ::write(fd, content.data(), content.size()) == ssize_t(content.size());
+          ::close(fd);
+          if(!written || ::rename(temporary.c_str(), path.c_str()) != 0) ::unlink(temporary.c_str());
+        }
+  };
+  /**
+   * @brief Reads a whole FileChannel tree (logPath/YYYY/MM/DD.log): only the files of the queried period are opened.
+   * 
+   */
+  class LogTreeReader
+  {
+    public:
+      // Construction ----
+        /**
+         * @brief Constructs a new LogTreeReader object.
+         * 
+         * @param logPath Root of the tree (the logPath of the FileChannel).
+         * @param DTFormat DateTime format of the FileChannel.
+         * @param indexPolicy How the indexes of the files are built and stored.
+         */
+        LogTreeReader(const std::filesystem::path& logPath, const std::string& DTFormat = "%Y-%m-%d %H:%M:%S", const LogIndexPolicy& indexPolicy = LogIndexPolicy())
+          :
+            _logPath(logPath),
+            _DTFormat(DTFormat),
+            _indexPolicy(indexPolicy)
+        {}
+
+      // Functions ----
+        /**
+         * @brief Calls the callback with every record matching the query (in time order of the files).
+         * 
+         * @tparam F Type of the callback: bool(const LogEntry&), returning false stops the query.
+         * @param query The query.
+         * @param callback The callback.
+         * @return true Every matching record is given.
+         * @return false The callback has stopped the query.
+         */
+        template<typename F>
+        bool query(const LogQuery& query, F&& callback)
+        {
+          for(const LogFileInfo& info : findLogFiles(_logPath))
+          {
+            // Only the files of the period
+            if(info.periodEnd <= query.from || info.periodStart >= query.to) continue;
+            LogFileReader reader(info.path, _DTFormat, _indexPolicy);
+            if(!reader.open()) continue;
+            _badTimestamps += reader.badTimestamps();
+            if(!reader.query(query, callback)) return false;
+          }
+          return true;
+        }
+        /**
+         * @brief Counts the records matching the query by type.
+         * 
+         * @param query The query.
+         * @return LogCounts The counts.
+         */
+        LogCounts count(const LogQuery& query)
+        {
+          LogCounts counts;
+          for(const LogFileInfo& info : findLogFiles(_logPath))
+          {
+            // Only the files of the period
+            if(info.periodEnd <= query.from || info.periodStart >= query.to) continue;
+            LogFileReader reader(info.path, _DTFormat, _indexPolicy);
+            if(!reader.open()) continue;
+            LogCounts fileCounts = reader.count(query);
+            _badTimestamps += reader.badTimestamps();
+            counts.total += fileCounts.total;
+            for(size_t slot = 0; slot < MSG_TYPE_COUNT; ++slot) counts.byType[slot] += fileCounts.byType[slot];
+          }
+          return counts;
+        }
+
+      // Getters ----
+        /**
+         * @brief Gets the number of the records whose timestamp couldn't be parsed (wrong DTFormat).
+         * 
+         * @return size_t Number of the records.
+         */
+        size_t badTimestamps() const
+        {
+          return _badTimestamps;
+        }
+
+    private:
+      // Variables ----
+        std::filesystem::path                   _logPath;                 // Root of the tree.
+        std::string                             _DTFormat;                // DateTime format of the timestamps.
+        LogIndexPolicy                          _indexPolicy;             // How the indexes are built and stored.
+        size_t                                  _badTimestamps = 0;       // Records with unparsable timestamps.
+  };
+}
+
+#endif
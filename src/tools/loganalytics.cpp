@@ -0,0 +1,382 @@
+/**
+ * @file loganalytics.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Aggregates the files of a FileChannel tree in parallel: records by type, records per sender per hour and the top messages.
+ * @details The files are mapped and split into chunks at record boundaries. The chunks are processed on a ThreadPool,
+ * every worker has its own partial aggregate (so they don't share anything while they work), and the partials
+ * are merged at the end. A processed chunk is dropped from the memory, so the files are streamed through.
+ * The messages are grouped by their text with the numbers replaced by '#'.
+ * 
+ * Options:
+ *   --from TIME       Start of the time range ("YYYY-MM-DD HH:MM:SS" or "YYYY-MM-DD", local time).
+ *   --to TIME         End of the time range (exclusive).
+ *   --type TYPES      Types of the per sender and top message statistics, separated by commas (default: ERR).
+ *   --format FORMAT   DateTime format of the FileChannel (default: "%Y-%m-%d %H:%M:%S").
+ *   --threads N       Number of the worker threads (default: hardware threads).
+ *   --top N           Number of the top messages (default: 10).
+ *   --chunk MB        Size of the chunks in megabytes (default: 4).
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <charconv>
+
+#include "../headers/general/threadpool.hpp"
+#include "../headers/general/sizes.hpp"
+#include "../headers/log/log_reader.hpp"
+
+/**
+ * @brief Settings of the analytics.
+ * 
+ */
+struct Settings
+{
+  std::string               logPath;                                        // Root of the tree.
+  std::string               format            = "%Y-%m-%d %H:%M:%S";        // DateTime format of the FileChannel.
+  std::chrono::system_clock::time_point   from = std::chrono::system_clock::time_point::min();  // Start of the time range.
+  std::chrono::system_clock::time_point   to = std::chrono::system_clock::time_point::max();    // End of the time range.
+  bool                      types[drLog::MSG_TYPE_COUNT] = { false, false, false, true, false }; // Types of the per sender and top message statistics.
+  size_t                    threads           = 1;                          // Number of the worker threads.
+  size_t                    top               = 10;                         // Number of the top messages.
+  size_t                    chunkBytes        = 4 * MB;                     // Size of the chunks.
+};
+
+/**
+ * @brief A part of a file processed by a task.
+ * 
+ */
+struct Chunk
+{
+  size_t                    file;                                           // Index of the file.
+  size_t                    begin;                                          // Start of the chunk (a record start).
+  size_t                    end;                                            // End of the chunk (a record start or the end of the file).
+};
+
+/**
+ * @brief Hash of the string keys (looked up by string_view without creating a string).
+ * 
+ */
+struct StringHash
+{
+  using is_transparent = void;
+  size_t operator()(std::string_view text) const
+  {
+    return std::hash<std::string_view>()(text);
+  }
+};
+template<typename T>
+using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+/**
+ * @brief The statistics of a worker (or the merged ones).
+ * 
+ */
+struct Aggregate
+{
+  drLog::LogCounts          counts;                                         // Records by type.
+  size_t                    bytes             = 0;                          // Processed bytes.
+  size_t                    badTimestamps     = 0;                          // Records with unparsable timestamps.
+  StringMap<std::map<int64_t, size_t>>    senderHours;                      // Records per sender per hour (hour start in seconds since the epoch).
+  StringMap<size_t>         messages;                                       // Records per message (numbers replaced by '#').
+  /**
+   * @brief Adds another aggregate into this one.
+   * 
+   * @param other The other aggregate.
+   */
+  void merge(Aggregate& other)
+  {
+    counts.total += other.counts.total;
+    for(size_t slot = 0; slot < drLog::MSG_TYPE_COUNT; ++slot) counts.byType[slot] += other.counts.byType[slot];
+    bytes += other.bytes;
+    badTimestamps += other.badTimestamps;
+    for(auto& [sender, hours] : other.senderHours)
+    {
+      std::map<int64_t, size_t>& target = senderHours[sender];
+      for(const auto& [hour, count] : hours) target[hour] += count;
+    }
+    for(auto& [message, count] : other.messages) messages[message] += count;
+  }
+};
+
+/**
+ * @brief The worker side of the analytics (its own parser, caches and aggregate).
+ * 
+ */
+class Worker
+{
+  public:
+    // Construction ----
+      /**
+       * @brief Constructs a new Worker object.
+       * 
+       * @param settings Settings of the analytics.
+       */
+      Worker(const Settings& settings)
+        :
+          _settings(settings),
+          _parser(settings.format)
+      {}
+
+    // Functions ----
+      /**
+       * @brief Processes a chunk.
+       * 
+       * @param data Content of the file.
+       * @param chunk The chunk.
+       */
+      void process(std::string_view data, const Chunk& chunk)
+      {
+        aggregate.bytes += chunk.end - chunk.begin;
+        drLog::LogEntry entry;
+        for(size_t position = chunk.begin; drLog::nextLogRecord(data, position, chunk.end, entry);)
+        {
+          // The time range
+          if(!_parser.parse(entry.timestamp, entry.dateTime))
+          {
+            ++aggregate.badTimestamps;
+            continue;
+          }
+          if(entry.dateTime < _settings.from || entry.dateTime >= _settings.to) continue;
+          // Records by type
+          size_t slot = drLog::getMsgTypeSlot(entry.type);
+          ++aggregate.counts.byType[slot];
+          ++aggregate.counts.total;
+          if(!_settings.types[slot]) continue;
+          // Records per sender per hour
+          auto sender = aggregate.senderHours.find(entry.sender);
+          if(sender == aggregate.senderHours.end()) sender = aggregate.senderHours.emplace(entry.sender, std::map<int64_t, size_t>()).first;
+          ++sender->second[_hourStart(entry.dateTime)];
+          // Records per message
+          _normalize(entry.message);
+          auto message = aggregate.messages.find(std::string_view(_message));
+          if(message == aggregate.messages.end()) aggregate.messages.emplace(_message, 1);
+          else ++message->second;
+        }
+      }
+
+    // Variables ----
+      Aggregate                 aggregate;                                  // Statistics of the worker.
+
+  private:
+    // Variables ----
+      const Settings&           _settings;                                  // Settings of the analytics.
+      Utils::DateTime::TimeStampParser        _parser;                      // Parser of the timestamps.
+      std::string               _message;                                   // The normalized message (reused).
+      int64_t                   _hourBegin        = 0;                      // Start of the last hour (seconds since the epoch).
+      int64_t                   _hourEnd          = 0;                      // End of the last hour.
+
+    // Functions ----
+      /**
+       * @brief Gets the start of the local hour of a time (the last hour is cached).
+       * 
+       * @param dateTime The time.
+       * @return int64_t Start of the hour in seconds since the epoch.
+       */
+      int64_t _hourStart(const std::chrono::system_clock::time_point& dateTime)
+      {
+        int64_t second = std::chrono::duration_cast<std::chrono::seconds>(dateTime.time_since_epoch()).count();
+        if(second >= _hourBegin && second < _hourEnd) return _hourBegin;
+        // A new hour (in local time, so the half hour time zones work too)
+        std::time_t time = std::time_t(second);
+        tm localTime;
+        localtime_r(&time, &localTime);
+        localTime.tm_min = 0;
+        localTime.tm_sec = 0;
+        _hourBegin = int64_t(mktime(&localTime));
+        _hourEnd = _hourBegin + 3600;
+        return _hourBegin;
+      }
+      /**
+       * @brief Normalizes a message: only the first line, with the numbers replaced by '#'.
+       * 
+       * @param message The message.
+       */
+      void _normalize(std::string_view message)
+      {
+        _message.clear();
+        message = message.substr(0, message.find('\n'));
+        for(size_t i = 0; i < message.size(); ++i)
+        {
+          // A number (with its decimal point) becomes one '#'
+          if(message[i] >= '0' && message[i] <= '9')
+          {
+            while(i + 1 < message.size() && ((message[i + 1] >= '0' && message[i + 1] <= '9') || message[i + 1] == '.')) ++i;
+            _message.push_back('#');
+          }
+          else _message.push_back(message[i]);
+        }
+      }
+};
+
+/**
+ * @brief Parses a number of the command line.
+ * 
+ * @param text The text.
+ * @param number The number.
+ * @return true The number is parsed.
+ * @return false Wrong number.
+ */
+bool parseNumber(std::string_view text, size_t& number)
+{
+  auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+  return error == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+
+int main(int argc, char* argv[])
+{
+  // Check the arguments
+  if(argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <log path> [--from TIME] [--to TIME] [--type ERR,WAR,...] [--format DTFORMAT] [--threads N] [--top N] [--chunk MB]\n";
+    return 1;
+  }
+  Settings settings;
+  settings.logPath = argv[1];
+  settings.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  for(int i = 2; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if(i + 1 >= argc)
+    {
+      std::cerr << "!!!--> Missing value: " << arg << " <--!!!\n";
+      return 1;
+    }
+    std::string value = argv[++i];
+    if(arg == "--format") settings.format = value;
+    else if(arg == "--threads" || arg == "--top" || arg == "--chunk")
+    {
+      size_t number = 0;
+      if(!parseNumber(value, number))
+      {
+        std::cerr << "!!!--> Wrong number: " << value << " <--!!!\n";
+        return 1;
+      }
+      if(arg == "--threads") settings.threads = std::max<size_t>(1, number);
+      else if(arg == "--top") settings.top = number;
+      else settings.chunkBytes = std::max<size_t>(1, number) * MB;
+    }
+    else if(arg == "--from" || arg == "--to")
+    {
+      if(!drLog::parseQueryTime(value, arg == "--from" ? settings.from : settings.to))
+      {
+        std::cerr << "!!!--> Wrong time: " << value << " <--!!!\n";
+        return 1;
+      }
+    }
+    else if(arg == "--type")
+    {
+      std::vector<drLog::MsgType> types;
+      std::string_view unknown;
+      if(!drLog::parseMsgTypeList(value, types, unknown))
+      {
+        std::cerr << "!!!--> Unknown type: " << unknown << " <--!!!\n";
+        return 1;
+      }
+      std::fill(std::begin(settings.types), std::end(settings.types), false);
+      for(drLog::MsgType type : types) settings.types[drLog::getMsgTypeSlot(type)] = true;
+    }
+    else
+    {
+      std::cerr << "!!!--> Unknown argument: " << arg << " <--!!!\n";
+      return 1;
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  // Map the files of the period and split them into chunks ----
+  std::vector<std::unique_ptr<drLog::LogFileMapping>> files;
+  std::vector<Chunk> chunks;
+  for(const drLog::LogFileInfo& info : drLog::findLogFiles(settings.logPath))
+  {
+    if(info.periodEnd <= settings.from || info.periodStart >= settings.to) continue;
+    auto file = std::make_unique<drLog::LogFileMapping>();
+    if(!file->open(info.path)) continue;
+    // The chunks start at records
+    std::string_view data = file->data();
+    for(size_t begin = 0; begin < data.size();)
+    {
+      size_t end = drLog::findLogRecordStart(data, std::min(begin + settings.chunkBytes, data.size()));
+      chunks.push_back( { files.size(), begin, end } );
+      begin = end;
+    }
+    files.push_back(std::move(file));
+  }
+
+  // Process the chunks in parallel ----
+  std::vector<std::unique_ptr<Worker>> workers;
+  for(size_t i = 0; i < settings.threads; ++i) workers.push_back(std::make_unique<Worker>(settings));
+  {
+    // Every task takes the chunks one by one, so the faster workers take more
+    std::atomic<size_t> next = 0;
+    ThreadPool pool(settings.threads);
+    for(std::unique_ptr<Worker>& worker : workers)
+    {
+      pool.enqueue([&next, &chunks, &files, worker = worker.get()]
+        {
+          for(size_t index = next.fetch_add(1); index < chunks.size(); index = next.fetch_add(1))
+          {
+            const Chunk& chunk = chunks[index];
+            drLog::LogFileMapping& file = *files[chunk.file];
+            file.advise(chunk.begin, chunk.end - chunk.begin, MADV_SEQUENTIAL);
+            worker->process(file.data(), chunk);
+            // We don't need the pages anymore
+            file.advise(chunk.begin, chunk.end - chunk.begin, MADV_DONTNEED);
+          }
+        }
+      );
+    }
+    // Wait for the tasks
+    pool.waitIdle();
+  }
+  // Merge the partial aggregates
+  Aggregate& result = workers[0]->aggregate;
+  for(size_t i = 1; i < workers.size(); ++i) result.merge(workers[i]->aggregate);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Print the results ----
+  // Records by type
+  std::cout << "# Records by type\n";
+  for(drLog::MsgType type : { drLog::MsgType::LOG_MSG, drLog::MsgType::LOG_INFO, drLog::MsgType::LOG_WARNING, drLog::MsgType::LOG_ERROR, drLog::MsgType::LOG_DEBUG })
+  {
+    std::cout << drLog::getMsgTypeStr(type) << "\t" << result.counts.byType[drLog::getMsgTypeSlot(type)] << "\n";
+  }
+  std::cout << "ALL\t" << result.counts.total << "\n";
+  // Records per sender per hour (senders in name order)
+  std::cout << "\n# Records per sender per hour\n";
+  std::map<std::string_view, const std::map<int64_t, size_t>*> senders;
+  for(const auto& [sender, hours] : result.senderHours) senders[sender] = &hours;
+  Utils::DateTime::TimeStampFormatter hourFormatter("%Y-%m-%d %H:00");
+  for(const auto& [sender, hours] : senders)
+  {
+    for(const auto& [hour, count] : *hours) std::cout << sender << "\t" << hourFormatter.format(std::time_t(hour)) << "\t" << count << "\n";
+  }
+  // Top messages
+  std::cout << "\n# Top messages\n";
+  std::vector<std::pair<size_t, std::string_view>> messages;
+  messages.reserve(result.messages.size());
+  for(const auto& [message, count] : result.messages) messages.emplace_back(count, message);
+  size_t top = std::min(settings.top, messages.size());
+  std::partial_sort(messages.begin(), messages.begin() + top, messages.end(), [](const auto& a, const auto& b)
+    {
+      return a.first != b.first ? a.first > b.first : a.second < b.second;
+    }
+  );
+  for(size_t i = 0; i < top; ++i) std::cout << messages[i].first << "\t" << messages[i].second << "\n";
+  // Summary
+  std::cerr << "Processed " << result.counts.total << " records (" << double(result.bytes) / double(MB) << " MB in " << chunks.size() << " chunks) in "
+            << seconds << " s on " << settings.threads << " threads: " << double(result.bytes) / double(MB) / seconds << " MB/s\n";
+  if(result.badTimestamps > 0) std::cerr << "!!!--> " << result.badTimestamps << " timestamps don't match the format: " << settings.format << " <--!!!\n";
+  return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file logdecode.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Converts the files of the BinaryChannel into the text layout of the FileChannel.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../headers/log/log_binarychannel.hpp"
+
+int main(int argc, char* argv[])
+{
+  // Check the arguments
+  if(argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <binary log file> [datetime format]\n";
+    return 1;
+  }
+  // Read the whole file
+  std::ifstream file(argv[1], std::ios::binary);
+  if(!file)
+  {
+    std::cerr << "!!!--> Failed to open: " << argv[1] << " <--!!!\n";
+    return 1;
+  }
+  std::stringstream content;
+  content << file.rdbuf();
+  std::string data = content.str();
+  // Decode it line by line
+  drLog::BinaryDecoder decoder(data, argc > 2 ? argv[2] : "");
+  std::string line;
+  while(decoder.next(line)) std::cout << line << "\n";
+  // Report the error (if we had one)
+  if(!decoder.error().empty())
+  {
+    std::cerr << "!!!--> " << decoder.error() << " <--!!!\n";
+    return 1;
+  }
+  return 0;
+}
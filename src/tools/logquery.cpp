@@ -0,0 +1,93 @@
+/**
+ * @file logquery.cpp
+ * @author Bradács András (bradacsandras@gmail.com)
+ * @brief Queries the files of a FileChannel tree by time range, type, sender and text (through their sparse indexes).
+ * @details Options:
+ *   --from TIME       Start of the time range ("YYYY-MM-DD HH:MM:SS" or "YYYY-MM-DD", local time).
+ *   --to TIME         End of the time range (exclusive).
+ *   --type TYPES      Wanted types, separated by commas (MSG,INF,WAR,ERR,DBG).
+ *   --sender NAME     Wanted sender.
+ *   --grep TEXT       The message has to contain the text.
+ *   --format FORMAT   DateTime format of the FileChannel (default: "%Y-%m-%d %H:%M:%S").
+ *   --count           Print the number of the matching records by type instead of the records.
+ *   --no-index        Don't store the indexes next to the files.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "../headers/log/log_reader.hpp"
+
+int main(int argc, char* argv[])
+{
+  // Check the arguments
+  if(argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <log path> [--from TIME] [--to TIME] [--type INF,ERR,...] [--sender NAME] [--grep TEXT] [--format DTFORMAT] [--count] [--no-index]\n";
+    return 1;
+  }
+  drLog::LogQuery query;
+  drLog::LogIndexPolicy indexPolicy;
+  std::string format = "%Y-%m-%d %H:%M:%S";
+  bool count = false;
+  for(int i = 2; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if(arg == "--count") count = true;
+    else if(arg == "--no-index") indexPolicy.storeIndex = false;
+    else if(arg == "--sender" && hasValue) query.sender = argv[++i];
+    else if(arg == "--grep" && hasValue) query.contains = argv[++i];
+    else if(arg == "--format" && hasValue) format = argv[++i];
+    else if((arg == "--from" || arg == "--to") && hasValue)
+    {
+      if(!drLog::parseQueryTime(argv[++i], arg == "--from" ? query.from : query.to))
+      {
+        std::cerr << "!!!--> Wrong time: " << argv[i] << " <--!!!\n";
+        return 1;
+      }
+    }
+    else if(arg == "--type" && hasValue)
+    {
+      std::string_view unknown;
+      if(!drLog::parseMsgTypeList(argv[++i], query.types, unknown))
+      {
+        std::cerr << "!!!--> Unknown type: " << unknown << " <--!!!\n";
+        return 1;
+      }
+    }
+    else
+    {
+      std::cerr << "!!!--> Unknown argument: " << arg << " <--!!!\n";
+      return 1;
+    }
+  }
+  // Run the query
+  drLog::LogTreeReader reader(argv[1], format, indexPolicy);
+  if(count)
+  {
+    drLog::LogCounts counts = reader.count(query);
+    for(drLog::MsgType type : { drLog::MsgType::LOG_MSG, drLog::MsgType::LOG_INFO, drLog::MsgType::LOG_WARNING, drLog::MsgType::LOG_ERROR, drLog::MsgType::LOG_DEBUG })
+    {
+      std::cout << drLog::getMsgTypeStr(type) << " " << counts.byType[drLog::getMsgTypeSlot(type)] << "\n";
+    }
+    std::cout << "ALL " << counts.total << "\n";
+  }
+  else
+  {
+    reader.query(query, [](const drLog::LogEntry& entry)
+      {
+        std::cout << entry.text << "\n";
+        return bool(std::cout);
+      }
+    );
+  }
+  // Warn about the wrong format
+  if(reader.badTimestamps() > 0) std::cerr << "!!!--> " << reader.badTimestamps() << " timestamps don't match the format: " << format << " <--!!!\n";
+  return 0;
+}